@@ -0,0 +1,329 @@
+// Copyright 2017-2019 Crytek GmbH / Crytek Group. All rights reserved.
+#include "StdAfx.h"
+#include "BallisticsSystem.h"
+
+#include <algorithm>
+#include <CrySystem/ConsoleRegistration.h>
+#include <CrySystem/IConsole.h>
+#include <CryRenderer/IRenderAuxGeom.h>
+#include <IGameFramework.h>
+#include <IMaterialEffects.h>
+
+#include <Components/ProjectilePool.h>
+#include <Components/RayCastService.h>
+
+namespace
+{
+	// Momentum handed to whatever a round hits
+	constexpr float kRoundMass = 0.05f;
+	// Surface effects played per frame, further impacts of the frame only push what they hit
+	constexpr int kMaxImpactEffects = 16;
+	// Half angle of the cone rounds are spread in
+	const float kSpreadAngle = DEG2RAD(0.75f);
+
+	// Integer hash to [0, 1), plain integer math so every platform gets the same rounds
+	float HashToUnit(uint32 value)
+	{
+		value ^= value >> 16;
+		value *= 0x7feb352d;
+		value ^= value >> 15;
+		value *= 0x846ca68b;
+		value ^= value >> 16;
+		return (float)(value >> 8) * (1.f / 16777216.f);
+	}
+
+	Matrix34 GetVisualTransform(const Vec3& position, const Vec3& velocity)
+	{
+		return Matrix34::Create(Vec3(CProjectilePool::GetBulletScale()), Quat::CreateRotationVDir(velocity.GetNormalizedSafe(FORWARD_DIRECTION)), position);
+	}
+}
+
+int CBallisticsSystem::s_maxLive = 2048;
+int CBallisticsSystem::s_debug = 0;
+
+const SWeaponBallistics& CBallisticsSystem::GetWeaponBallistics(EWeaponType weapon)
+{
+	static const SWeaponBallistics weapons[] =
+	{
+		// muzzle speed, lifetime, range
+		{ 1000.f, 3.f, 2000.f }, // Rifle
+	};
+	static_assert(CRY_ARRAY_COUNT(weapons) == (size_t)EWeaponType::Count, "Every weapon needs its ballistics");
+
+	return weapons[weapon < EWeaponType::Count ? (size_t)weapon : 0];
+}
+
+void CBallisticsSystem::Fire(const Vec3& origin, const Vec3& direction, EWeaponType weapon, EntityId ownerId)
+{
+	// At the cap the oldest live round makes room, rounds are in firing order
+	if (s_maxLive > 0 && GetLiveCount() >= (size_t)s_maxLive && m_pendingEvictions < m_positions.size())
+	{
+		++m_pendingEvictions;
+	}
+
+	const SWeaponBallistics& ballistics = GetWeaponBallistics(weapon);
+	const Vec3 velocity = direction * ballistics.muzzleSpeed;
+
+	m_ids.push_back(m_nextRoundId++);
+	m_positions.push_back(origin);
+	m_velocities.push_back(velocity);
+	m_timeToLive.push_back(ballistics.maxLifetime);
+	m_rangeLeft.push_back(ballistics.maxRange);
+	m_owners.push_back(ownerId);
+	m_visualSlots.push_back(CProjectilePool::GetInstance().Acquire(GetVisualTransform(origin, velocity)));
+	m_checkedPositions.push_back(origin);
+	m_rayEnds.push_back(origin);
+	m_raysInFlight.push_back(0);
+}
+
+void CBallisticsSystem::FireBurst(const Vec3& origin, const Vec3& direction, uint32 seed, uint8 count, EWeaponType weapon, EntityId ownerId)
+{
+	for (uint8 round = 0; round < count; ++round)
+	{
+		Fire(origin, GetRoundDirection(direction, seed, round), weapon, ownerId);
+	}
+}
+
+Vec3 CBallisticsSystem::GetRoundDirection(const Vec3& direction, uint32 seed, uint8 round)
+{
+	// Uniform over the cone's disk: sqrt on the radius, any angle around the aim
+	const uint32 roundSeed = seed + round * 0x9e3779b9u;
+	const float radius = sqrtf(HashToUnit(roundSeed)) * tanf(kSpreadAngle);
+	const float angle = HashToUnit(roundSeed ^ 0x68e31da4u) * gf_PI2;
+
+	const Vec3 aim = direction.GetNormalizedSafe(FORWARD_DIRECTION);
+	const Vec3 right = aim.GetOrthogonal().GetNormalized();
+	const Vec3 up = aim.Cross(right);
+	return (aim + (right * cosf(angle) + up * sinf(angle)) * radius).GetNormalized();
+}
+
+void CBallisticsSystem::Clear()
+{
+	ResizeRounds(0);
+	m_impacts.clear();
+	m_rayResults.clear();
+	m_pendingEvictions = 0;
+	m_evictedCount = 0;
+}
+
+void CBallisticsSystem::Update(float frameTime)
+{
+	if (s_debug != 0 && gEnv->pAuxGeomRenderer)
+	{
+		const float color[4] = { 1, 1, 1, 1 };
+		gEnv->pAuxGeomRenderer->Draw2dLabel(50, 260, 1.5f, color, false, "Rounds: %u live, %u evicted", (uint32)GetLiveCount(), m_evictedCount);
+	}
+
+	// Answers for rounds that are all gone
+	if (m_positions.empty())
+		m_rayResults.clear();
+
+	if (m_positions.empty() || frameTime <= 0.f)
+		return;
+
+	// Constant gravity, the arc over the frame is exact: p + v t + g t^2 / 2
+	const Vec3 gravity = gEnv->pPhysicalWorld->GetPhysVars()->gravity;
+	const Vec3 gravityStep = gravity * frameTime;
+	const Vec3 gravityOffset = gravity * (0.5f * frameTime * frameTime);
+
+	CProjectilePool& pool = CProjectilePool::GetInstance();
+
+	// Ray answers sorted by round id, like the rounds, so the sweep walks both together
+	std::sort(m_rayResults.begin(), m_rayResults.end(), [](const SRayResult& a, const SRayResult& b) { return a.roundId < b.roundId; });
+	size_t resultIndex = 0;
+
+	// One sweep: finished rounds are released, the others packed to the front in the same order
+	size_t liveCount = 0;
+	for (size_t round = 0; round < m_positions.size(); ++round)
+	{
+		// Answers for rounds evicted since are dropped
+		while (resultIndex < m_rayResults.size() && m_rayResults[resultIndex].roundId < m_ids[round])
+			++resultIndex;
+
+		bool isHit = false;
+		if (resultIndex < m_rayResults.size() && m_rayResults[resultIndex].roundId == m_ids[round])
+			isHit = ResolveRay(round, m_rayResults[resultIndex++]);
+
+		const bool isEvicted = round < m_pendingEvictions;
+		const bool isMoving = !isEvicted && !isHit && StepRound(round, frameTime, gravityStep, gravityOffset);
+
+		// A spent round is hidden at once, but kept until the rest of its path is checked
+		if (!isMoving && m_visualSlots[round] != CProjectilePool::kInvalidSlot)
+		{
+			pool.Release(m_visualSlots[round]);
+			m_visualSlots[round] = CProjectilePool::kInvalidSlot;
+		}
+
+		if (isEvicted || isHit)
+			continue;
+
+		if (!m_raysInFlight[round] && m_checkedPositions[round] != m_positions[round])
+			SubmitRay(round);
+
+		if (!isMoving && !m_raysInFlight[round])
+			continue;
+
+		if (m_visualSlots[round] != CProjectilePool::kInvalidSlot)
+			pool.Move(m_visualSlots[round], GetVisualTransform(m_positions[round], m_velocities[round]));
+
+		if (liveCount != round)
+			MoveRound(round, liveCount);
+		++liveCount;
+	}
+
+	m_rayResults.clear();
+	m_evictedCount += (uint32)m_pendingEvictions;
+	m_pendingEvictions = 0;
+	ResizeRounds(liveCount);
+
+	ProcessImpacts();
+}
+
+bool CBallisticsSystem::StepRound(size_t round, float frameTime, const Vec3& gravityStep, const Vec3& gravityOffset)
+{
+	m_timeToLive[round] -= frameTime;
+	if (m_timeToLive[round] <= 0.f)
+		return false;
+
+	const Vec3 from = m_positions[round];
+	const Vec3 to = from + m_velocities[round] * frameTime + gravityOffset;
+
+	m_rangeLeft[round] -= from.GetDistance(to);
+	if (m_rangeLeft[round] <= 0.f)
+	{
+		m_timeToLive[round] = 0.f;
+		return false;
+	}
+
+	m_positions[round] = to;
+	m_velocities[round] += gravityStep;
+	return true;
+}
+
+bool CBallisticsSystem::ResolveRay(size_t round, const SRayResult& result)
+{
+	m_raysInFlight[round] = 0;
+	if (!result.isHit)
+	{
+		m_checkedPositions[round] = m_rayEnds[round];
+		return false;
+	}
+
+	IPhysicalEntity* pCollider = nullptr;
+	if (IEntity* pEntity = gEnv->pEntitySystem->GetEntity(result.entityId))
+		pCollider = pEntity->GetPhysics();
+
+	m_impacts.push_back(SImpact{ pCollider, result.point, result.normal, m_velocities[round] * kRoundMass, result.surfaceId, m_owners[round] });
+	return true;
+}
+
+void CBallisticsSystem::SubmitRay(size_t round)
+{
+	const uint32 roundId = m_ids[round];
+	const Vec3 from = m_checkedPositions[round];
+	m_rayEnds[round] = m_positions[round];
+	m_raysInFlight[round] = 1;
+
+	// Only the id is captured, the callback fits in the small buffer of std::function
+	CRayCastService::GetInstance().Submit(from, m_positions[round] - from, m_owners[round], [this, roundId](const CRayCastService::SResult& result)
+	{
+		const EntityId entityId = result.pEntity ? result.pEntity->GetId() : INVALID_ENTITYID;
+		m_rayResults.push_back(SRayResult{ roundId, result.isHit, result.point, result.normal, result.surfaceId, entityId });
+	});
+}
+
+void CBallisticsSystem::ProcessImpacts()
+{
+	if (m_impacts.empty())
+		return;
+
+	IMaterialEffects* pMaterialEffects = gEnv->pGameFramework ? gEnv->pGameFramework->GetIMaterialEffects() : nullptr;
+	const int bulletSurfaceId = GetBulletSurfaceId();
+	int effectCount = 0;
+
+	for (const SImpact& impact : m_impacts)
+	{
+		// Rigid bodies take the round's momentum, static geometry only stops it
+		if (impact.pCollider && impact.pCollider->GetType() != PE_STATIC)
+		{
+			pe_action_impulse impulseAction;
+			impulseAction.impulse = impact.impulse;
+			impulseAction.point = impact.point;
+			impact.pCollider->Action(&impulseAction);
+		}
+
+		// The bullet surface against the surface hit, as set up in Libs/MaterialEffects
+		if (pMaterialEffects && bulletSurfaceId >= 0 && effectCount < kMaxImpactEffects)
+		{
+			const TMFXEffectId effectId = pMaterialEffects->GetEffectId(bulletSurfaceId, impact.surfaceId);
+			if (effectId != InvalidEffectId)
+			{
+				SMFXRunTimeEffectParams effectParams;
+				effectParams.pos = impact.point;
+				effectParams.normal = impact.normal;
+				pMaterialEffects->ExecuteEffect(effectId, effectParams);
+				++effectCount;
+			}
+		}
+	}
+
+	m_impacts.clear();
+}
+
+int CBallisticsSystem::GetBulletSurfaceId()
+{
+	// 'mat_bullet', the surface type of the bullet material
+	if (m_bulletSurfaceId < 0)
+	{
+		if (ISurfaceType* pSurfaceType = gEnv->p3DEngine->GetMaterialManager()->GetSurfaceTypeManager()->GetSurfaceTypeByName("mat_bullet"))
+			m_bulletSurfaceId = pSurfaceType->GetId();
+	}
+
+	return m_bulletSurfaceId;
+}
+
+void CBallisticsSystem::MoveRound(size_t from, size_t to)
+{
+	m_ids[to] = m_ids[from];
+	m_positions[to] = m_positions[from];
+	m_velocities[to] = m_velocities[from];
+	m_timeToLive[to] = m_timeToLive[from];
+	m_rangeLeft[to] = m_rangeLeft[from];
+	m_owners[to] = m_owners[from];
+	m_visualSlots[to] = m_visualSlots[from];
+	m_checkedPositions[to] = m_checkedPositions[from];
+	m_rayEnds[to] = m_rayEnds[from];
+	m_raysInFlight[to] = m_raysInFlight[from];
+}
+
+void CBallisticsSystem::ResizeRounds(size_t count)
+{
+	m_ids.resize(count);
+	m_positions.resize(count);
+	m_velocities.resize(count);
+	m_timeToLive.resize(count);
+	m_rangeLeft.resize(count);
+	m_owners.resize(count);
+	m_visualSlots.resize(count);
+	m_checkedPositions.resize(count);
+	m_rayEnds.resize(count);
+	m_raysInFlight.resize(count);
+}
+
+///////////////////////////////////////////////////////////////////////////
+// CONSOLE
+///////////////////////////////////////////////////////////////////////////
+void CBallisticsSystem::RegisterConsoleCommands()
+{
+	REGISTER_CVAR2("projectile_maxLive", &s_maxLive, s_maxLive, VF_NULL, "Maximum rounds in flight, firing past it drops the oldest round. 0 is unlimited");
+	REGISTER_CVAR2("projectile_debug", &s_debug, s_debug, VF_NULL, "1 shows the live and evicted round counters");
+}
+
+void CBallisticsSystem::UnregisterConsoleCommands()
+{
+	if (gEnv->pConsole)
+	{
+		gEnv->pConsole->UnregisterVariable("projectile_maxLive");
+		gEnv->pConsole->UnregisterVariable("projectile_debug");
+	}
+}
@@ -0,0 +1,128 @@
+// Copyright 2017-2021 Crytek GmbH / Crytek Group. All rights reserved.
+#pragma once
+#include <vector>
+
+#include <CryPhysics/physinterface.h>
+
+enum class EWeaponType : uint8
+{
+	Rifle,
+
+	Count
+};
+
+// Flight limits of a weapon's rounds
+struct SWeaponBallistics
+{
+	float muzzleSpeed;
+	float maxLifetime; // Seconds before a round that hit nothing is dropped
+	float maxRange; // Distance flown before a round that hit nothing is dropped
+};
+
+////////////////////////////////////////////////////////
+// Every round in flight, in flat arrays kept in firing order (id, position, velocity, time to live, range left, owner, visual, ray state).
+// Once per frame a single sweep moves all rounds along their ballistic arc in closed form and drops the rounds that hit, were evicted,
+// or are spent (expired or out of range) with their whole path checked.
+// Paths are checked through CRayCastService: a round has at most one ray in flight, from the last checked point to where it is now.
+// Answers come back in a later frame and are merged into the sweep by round id, so impacts are resolved a frame or two late.
+// Rounds have no physical entity, the bullet visuals come from CProjectilePool.
+// Impacts found by the sweep are buffered and handled in one batch after it: impulse on the body hit, surface effect (capped per frame).
+//   projectile_maxLive    live rounds cap, firing past it evicts the oldest round
+//   projectile_debug      1 shows the live and evicted counters
+////////////////////////////////////////////////////////
+class CBallisticsSystem
+{
+public:
+	static CBallisticsSystem& GetInstance()
+	{
+		static CBallisticsSystem instance;
+		return instance;
+	}
+
+	static const SWeaponBallistics& GetWeaponBallistics(EWeaponType weapon);
+
+	// Fires a round from origin along direction (normalized), the owner is never hit by its own round
+	void Fire(const Vec3& origin, const Vec3& direction, EWeaponType weapon, EntityId ownerId);
+	// Fires count rounds spread around direction, the same seed gives the same rounds on every machine
+	void FireBurst(const Vec3& origin, const Vec3& direction, uint32 seed, uint8 count, EWeaponType weapon, EntityId ownerId);
+
+	// Direction of a round of a burst, within the spread cone around direction
+	static Vec3 GetRoundDirection(const Vec3& direction, uint32 seed, uint8 round);
+
+	// Called once per frame
+	void Update(float frameTime);
+	void Clear();
+
+	// Rounds in flight, evicted ones excluded
+	size_t GetLiveCount() const { return m_positions.size() - m_pendingEvictions; }
+	// Rounds dropped for the cap since the level started
+	uint32 GetEvictedCount() const { return m_evictedCount; }
+
+	static void RegisterConsoleCommands();
+	static void UnregisterConsoleCommands();
+
+private:
+	CBallisticsSystem() = default;
+	CBallisticsSystem(const CBallisticsSystem&) = delete;
+	CBallisticsSystem& operator=(const CBallisticsSystem&) = delete;
+
+	// Moves the round over the frame, false once it is spent (expired, out of range)
+	bool StepRound(size_t round, float frameTime, const Vec3& gravityStep, const Vec3& gravityOffset);
+
+	// Answer of a path ray, stored until the next sweep
+	struct SRayResult
+	{
+		uint32 roundId;
+		bool isHit;
+		Vec3 point;
+		Vec3 normal;
+		int surfaceId;
+		EntityId entityId;
+	};
+
+	// Applies the answer of the round's ray, true if the round stopped on it (the impact is buffered)
+	bool ResolveRay(size_t round, const SRayResult& result);
+	// Ray from the last checked point to the round's position
+	void SubmitRay(size_t round);
+
+	// An impact of the current sweep
+	struct SImpact
+	{
+		IPhysicalEntity* pCollider;
+		Vec3 point;
+		Vec3 normal;
+		Vec3 impulse;
+		int surfaceId;
+		EntityId ownerId;
+	};
+
+	void ProcessImpacts();
+	int GetBulletSurfaceId();
+	void MoveRound(size_t from, size_t to);
+	void ResizeRounds(size_t count);
+
+	std::vector<uint32> m_ids; // Increasing in firing order, like the arrays
+	std::vector<Vec3> m_positions;
+	std::vector<Vec3> m_velocities;
+	std::vector<float> m_timeToLive;
+	std::vector<float> m_rangeLeft;
+	std::vector<EntityId> m_owners;
+	std::vector<uint32> m_visualSlots;
+	std::vector<Vec3> m_checkedPositions; // The path up to here has no hit
+	std::vector<Vec3> m_rayEnds; // End of the ray in flight
+	std::vector<uint8> m_raysInFlight;
+
+	uint32 m_nextRoundId = 1;
+	std::vector<SRayResult> m_rayResults;
+
+	std::vector<SImpact> m_impacts;
+	int m_bulletSurfaceId = -1;
+
+	// The oldest rounds, at the front, are evicted by the next sweep
+	size_t m_pendingEvictions = 0;
+	uint32 m_evictedCount = 0;
+
+	// CVars
+	static int s_maxLive;
+	static int s_debug;
+};
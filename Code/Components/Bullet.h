@@ -1,8 +1,11 @@
 // Copyright 2017-2019 Crytek GmbH / Crytek Group. All rights reserved.
 #pragma once
 
+#include <Components/ProjectilePool.h>
+
 ////////////////////////////////////////////////////////
-// Physicalized bullet shot from weaponry, expires on collision with another object
+// Visual of a bullet shot from weaponry, pooled by CProjectilePool.
+// It has no physics: the round itself is simulated by CBallisticsSystem, which moves this entity along.
 ////////////////////////////////////////////////////////
 class CBulletComponent final : public IEntityComponent
 {
@@ -16,34 +19,12 @@ public:
 		const int geometrySlot = 0;
 		m_pEntity->LoadGeometry(geometrySlot, "%ENGINE%/EngineAssets/Objects/primitive_sphere.cgf");
 
-		// Load the custom bullet material.
-		// This material has the 'mat_bullet' surface type applied, which is set up to play sounds on collision with 'mat_default' objects in Libs/MaterialEffects
-		auto *pBulletMaterial = gEnv->p3DEngine->GetMaterialManager()->LoadMaterial("Materials/bullet");
-		m_pEntity->SetMaterial(pBulletMaterial);
-
-		// Now create the physical representation of the entity
-		SEntityPhysicalizeParams physParams;
-		physParams.type = PE_RIGID;
-		physParams.mass = 20000.f;
-		m_pEntity->Physicalize(physParams);
+		// The custom bullet material, loaded once by the pool.
+		m_pEntity->SetMaterial(CProjectilePool::GetInstance().GetMaterial());
 
 		// Make sure that bullets are always rendered regardless of distance
 		// Ratio is 0 - 255, 255 being 100% visibility
 		GetEntity()->SetViewDistRatio(255);
-
-		// Apply an impulse so that the bullet flies forward
-		if (auto *pPhysics = GetEntity()->GetPhysics())
-		{
-			pe_action_impulse impulseAction;
-
-			const float initialVelocity = 1000.f;
-
-			// Set the actual impulse, in this cause the value of the initial velocity CVar in bullet's forward direction
-			impulseAction.impulse = GetEntity()->GetWorldRotation().GetColumn1() * initialVelocity;
-
-			// Send to the physical entity
-			pPhysics->Action(&impulseAction);
-		}
 	}
 
 	// Reflect type to set a unique identifier for this component
@@ -51,19 +32,22 @@ public:
 	{
 		desc.SetGUID("{B53A9A5F-F27A-42CB-82C7-B1E379C41A2A}"_cry_guid);
 	}
+	// ~IEntityComponent
 
-	virtual Cry::Entity::EventFlags GetEventMask() const override { return ENTITY_EVENT_COLLISION; }
-	virtual void ProcessEvent(const SEntityEvent& event) override
+	void Show(const Matrix34& transform)
 	{
-		// Handle the OnCollision event, in order to have the entity removed on collision
-		if (event.event == ENTITY_EVENT_COLLISION)
-		{
-			// Collision info can be retrieved using the event pointer
-			//EventPhysCollision *physCollision = reinterpret_cast<EventPhysCollision *>(event.ptr);
+		m_pEntity->SetWorldTM(transform);
+		m_pEntity->Hide(false);
+	}
 
-			// Queue removal of this entity, unless it has already been done
-			gEnv->pEntitySystem->RemoveEntity(GetEntityId());
-		}
+	void Move(const Matrix34& transform)
+	{
+		m_pEntity->SetWorldTM(transform);
 	}
-	// ~IEntityComponent
-};
\ No newline at end of file
+
+	// Hidden until the next round uses it
+	void Deactivate()
+	{
+		m_pEntity->Hide(true);
+	}
+};
@@ -0,0 +1,67 @@
+// Copyright 2017-2019 Crytek GmbH / Crytek Group. All rights reserved.
+#include "StdAfx.h"
+#include "FireReplication.h"
+
+#include <algorithm>
+
+#include "GamePlugin.h"
+#include <Components/FlightSystem.h>
+#include <Components/Player.h>
+
+void CFireReplication::Queue(EntityId shooterId, int channelId, const SFireEvent& event)
+{
+	m_events.push_back(SQueuedEvent{ shooterId, channelId, event });
+}
+
+void CFireReplication::Clear()
+{
+	m_events.clear();
+	m_tickTimer = 0.f;
+}
+
+void CFireReplication::Update(float frameTime)
+{
+	if (!gEnv->bServer)
+		return;
+
+	// Same tick as the ship snapshots, 0 ticks every frame
+	const int snapshotRate = CFlightSystem::GetSnapshotRate();
+	m_tickTimer -= frameTime;
+	if (snapshotRate > 0 && m_tickTimer > 0.f)
+		return;
+
+	m_tickTimer = std::max(m_tickTimer + (snapshotRate > 0 ? 1.f / (float)snapshotRate : frameTime), 0.f);
+
+	if (m_events.empty())
+		return;
+
+	CGamePlugin::GetInstance()->IterateOverPlayers([this](CPlayerComponent& player)
+	{
+		// The server fired every round already
+		if (player.IsLocalClient())
+			return;
+
+		const int channelId = player.GetEntity()->GetNetEntity()->GetChannelId();
+
+		SFireEventPacket packet;
+		for (const SQueuedEvent& queued : m_events)
+		{
+			// The shooter fired its own rounds when it pulled the trigger
+			if (queued.channelId == channelId)
+				continue;
+
+			packet.shooterIds[packet.count] = queued.shooterId;
+			packet.events[packet.count] = queued.event;
+			if (++packet.count == SFireEventPacket::kMaxEvents)
+			{
+				player.SendFireEvents(std::move(packet));
+				packet = SFireEventPacket();
+			}
+		}
+
+		if (packet.count > 0)
+			player.SendFireEvents(std::move(packet));
+	});
+
+	m_events.clear();
+}
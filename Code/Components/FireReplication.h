@@ -0,0 +1,116 @@
+// Copyright 2017-2021 Crytek GmbH / Crytek Group. All rights reserved.
+#pragma once
+#include <array>
+#include <vector>
+
+#include <Components/BallisticsSystem.h>
+
+// Rounds fired together by a shooter. Every peer rebuilds the same rounds from the seed (see CBallisticsSystem::FireBurst).
+struct SFireEvent
+{
+	static constexpr uint8 kMaxBurst = 8;
+
+	float viewTime = 0.f; // Server level time the shooter was seeing, for lag compensation
+	Vec3 origin = ZERO;
+	Vec3 direction = FORWARD_DIRECTION;
+	uint32 seed = 0;
+	uint8 burstCount = 1;
+	EWeaponType weapon = EWeaponType::Rifle;
+
+	void SerializeWith(TSerialize ser)
+	{
+		ser.Value("viewTime", viewTime);
+		// Lossless: the shooter fires from these exact values, the other peers must rebuild the same rounds
+		ser.Value("origin", origin);
+		ser.Value("direction", direction);
+		ser.Value("seed", seed);
+		ser.Value("burstCount", burstCount);
+
+		uint8 weaponValue = (uint8)weapon;
+		ser.Value("weapon", weaponValue);
+		weapon = weaponValue < (uint8)EWeaponType::Count ? (EWeaponType)weaponValue : EWeaponType::Rifle;
+
+		if (burstCount == 0)
+			burstCount = 1;
+		else if (burstCount > kMaxBurst)
+			burstCount = kMaxBurst;
+	}
+};
+
+// Shooter to server: the fire events of one network tick
+struct SFireBatch
+{
+	static constexpr uint8 kMaxEvents = 16;
+
+	float interpolationDelay = 0.f;
+	uint8 count = 0;
+	std::array<SFireEvent, kMaxEvents> events;
+
+	void SerializeWith(TSerialize ser)
+	{
+		ser.Value("interpolationDelay", interpolationDelay);
+		ser.Value("count", count);
+		if (count > kMaxEvents)
+			count = kMaxEvents;
+		for (uint8 i = 0; i < count; ++i)
+			events[i].SerializeWith(ser);
+	}
+};
+
+// Server to client: the fire events of every other shooter over one tick
+struct SFireEventPacket
+{
+	static constexpr uint8 kMaxEvents = 32;
+
+	uint8 count = 0;
+	std::array<EntityId, kMaxEvents> shooterIds;
+	std::array<SFireEvent, kMaxEvents> events;
+
+	void SerializeWith(TSerialize ser)
+	{
+		ser.Value("count", count);
+		if (count > kMaxEvents)
+			count = kMaxEvents;
+		for (uint8 i = 0; i < count; ++i)
+		{
+			ser.Value("shooterId", shooterIds[i], 'eid');
+			events[i].SerializeWith(ser);
+		}
+	}
+};
+
+////////////////////////////////////////////////////////
+// Server side fan-out of the fire events. Events received from the shooters during a flight_snapshotRate tick
+// go to each client in one packet (split past SFireEventPacket::kMaxEvents), without the client's own events.
+////////////////////////////////////////////////////////
+class CFireReplication
+{
+public:
+	static CFireReplication& GetInstance()
+	{
+		static CFireReplication instance;
+		return instance;
+	}
+
+	// Server: an event of the shooter on channelId, sent to every other client with the next tick
+	void Queue(EntityId shooterId, int channelId, const SFireEvent& event);
+
+	// Server only, called once per frame
+	void Update(float frameTime);
+	void Clear();
+
+private:
+	CFireReplication() = default;
+	CFireReplication(const CFireReplication&) = delete;
+	CFireReplication& operator=(const CFireReplication&) = delete;
+
+	struct SQueuedEvent
+	{
+		EntityId shooterId;
+		int channelId;
+		SFireEvent event;
+	};
+
+	std::vector<SQueuedEvent> m_events;
+	float m_tickTimer = 0.f;
+};
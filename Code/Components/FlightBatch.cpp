@@ -0,0 +1,166 @@
+// Copyright 2017-2019 Crytek GmbH / Crytek Group. All rights reserved.
+#include "FlightBatch.h"
+
+///////////////////////////////////////////////////////////////////////////
+// PER SHIP PARAMETERS
+///////////////////////////////////////////////////////////////////////////
+void CFlightBatch::SJerkGroupArrays::Resize(size_t size)
+{
+	currentAccel.Resize(size);
+	targetAccel.Resize(size);
+	jerk.resize(size, 0.f);
+	jerkDecelRate.resize(size, 0.f);
+	accelerating.resize(size, 0);
+}
+
+void CFlightBatch::Resize(size_t size)
+{
+	for (SJerkGroupArrays& group : m_jerkGroups)
+		group.Resize(size);
+
+	m_mass.resize(size, 0.f);
+	m_linearScale.resize(size, 1.f);
+	m_angularScale.resize(size, 1.f);
+	m_linearImpulse.Resize(size);
+	m_angularImpulse.Resize(size);
+}
+
+void CFlightBatch::SetJerkRates(SlotId slot, EJerkGroup group, float jerk, float jerkDecelRate)
+{
+	SJerkGroupArrays& groupArrays = m_jerkGroups[(size_t)group];
+	groupArrays.jerk[slot] = jerk;
+	groupArrays.jerkDecelRate[slot] = jerkDecelRate;
+}
+
+void CFlightBatch::ResetJerk(SlotId slot)
+{
+	for (SJerkGroupArrays& group : m_jerkGroups)
+	{
+		group.currentAccel.Set(slot, SFlightVec3());
+		group.targetAccel.Set(slot, SFlightVec3());
+		group.accelerating[slot] = 0;
+	}
+	m_linearImpulse.Set(slot, SFlightVec3());
+	m_angularImpulse.Set(slot, SFlightVec3());
+}
+
+void CFlightBatch::SetImpulseScale(SlotId slot, float mass, float linearScale, float angularScale)
+{
+	m_mass[slot] = mass;
+	m_linearScale[slot] = linearScale;
+	m_angularScale[slot] = angularScale;
+}
+
+void CFlightBatch::SetTargetAccel(SlotId slot, EJerkGroup group, const SFlightVec3& targetAccel, EAccelState state)
+{
+	SJerkGroupArrays& groupArrays = m_jerkGroups[(size_t)group];
+	groupArrays.targetAccel.Set(slot, targetAccel);
+	groupArrays.accelerating[slot] = state == EAccelState::Accelerating ? 1 : 0;
+}
+
+EAccelState CFlightBatch::GetAccelState(SlotId slot, EJerkGroup group) const
+{
+	return m_jerkGroups[(size_t)group].accelerating[slot] ? EAccelState::Accelerating : EAccelState::Decelerating;
+}
+
+void CFlightBatch::SetCurrentAccel(SlotId slot, EJerkGroup group, const SFlightVec3& currentAccel)
+{
+	m_jerkGroups[(size_t)group].currentAccel.Set(slot, currentAccel);
+}
+
+SFlightVec3 CFlightBatch::GetCurrentAccel(SlotId slot, EJerkGroup group) const
+{
+	return m_jerkGroups[(size_t)group].currentAccel.Get(slot);
+}
+
+JerkAccelerationData CFlightBatch::GetJerkData(SlotId slot, EJerkGroup group) const
+{
+	const SJerkGroupArrays& groupArrays = m_jerkGroups[(size_t)group];
+
+	JerkAccelerationData data;
+	data.jerk = groupArrays.jerk[slot];
+	data.jerkDecelRate = groupArrays.jerkDecelRate[slot];
+	data.currentJerkAccel = groupArrays.currentAccel.Get(slot);
+	data.targetJerkAccel = groupArrays.targetAccel.Get(slot);
+	data.state = groupArrays.accelerating[slot] ? EAccelState::Accelerating : EAccelState::Decelerating;
+	return data;
+}
+
+std::array<JerkAccelerationData, (size_t)EJerkGroup::Count> CFlightBatch::GetJerkData(SlotId slot) const
+{
+	std::array<JerkAccelerationData, (size_t)EJerkGroup::Count> data;
+	for (size_t group = 0; group < (size_t)EJerkGroup::Count; ++group)
+		data[group] = GetJerkData(slot, (EJerkGroup)group);
+	return data;
+}
+
+void CFlightBatch::CopyInputs(const CFlightBatch& source, SlotId slot)
+{
+	for (size_t group = 0; group < (size_t)EJerkGroup::Count; ++group)
+	{
+		const SJerkGroupArrays& from = source.m_jerkGroups[group];
+		SJerkGroupArrays& to = m_jerkGroups[group];
+		to.targetAccel.Set(slot, from.targetAccel.Get(slot));
+		to.jerk[slot] = from.jerk[slot];
+		to.jerkDecelRate[slot] = from.jerkDecelRate[slot];
+		to.accelerating[slot] = from.accelerating[slot];
+	}
+
+	m_mass[slot] = source.m_mass[slot];
+	m_linearScale[slot] = source.m_linearScale[slot];
+	m_angularScale[slot] = source.m_angularScale[slot];
+}
+
+void CFlightBatch::CopyCurrentAccel(const CFlightBatch& source, SlotId slot)
+{
+	for (size_t group = 0; group < (size_t)EJerkGroup::Count; ++group)
+	{
+		m_jerkGroups[group].currentAccel.Set(slot, source.m_jerkGroups[group].currentAccel.Get(slot));
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////
+// STEPPING
+///////////////////////////////////////////////////////////////////////////
+void CFlightBatch::StepRange(float frameTime, size_t begin, size_t end)
+{
+	for (SJerkGroupArrays& group : m_jerkGroups)
+	{
+		StepJerkGroup(group, frameTime, begin, end);
+	}
+
+	// Convert the accelerations (after jerk) into impulses, roll and pitch / yaw are combined
+	const SJerkGroupArrays& linear = m_jerkGroups[(size_t)EJerkGroup::Linear];
+	const SJerkGroupArrays& roll = m_jerkGroups[(size_t)EJerkGroup::Roll];
+	const SJerkGroupArrays& pitchYaw = m_jerkGroups[(size_t)EJerkGroup::PitchYaw];
+
+	for (size_t i = begin; i < end; ++i)
+	{
+		const SFlightVec3 angularAccel = roll.currentAccel.Get(i) + pitchYaw.currentAccel.Get(i);
+		m_linearImpulse.Set(i, CFlightModel::AccelToImpulse(linear.currentAccel.Get(i), m_mass[i], m_linearScale[i], frameTime));
+		m_angularImpulse.Set(i, CFlightModel::AccelToImpulse(angularAccel, m_mass[i], m_angularScale[i], frameTime));
+	}
+}
+
+void CFlightBatch::StepJerkGroup(SJerkGroupArrays& group, float frameTime, size_t begin, size_t end)
+{
+	float* __restrict currentX = group.currentAccel.x.data();
+	float* __restrict currentY = group.currentAccel.y.data();
+	float* __restrict currentZ = group.currentAccel.z.data();
+	const float* __restrict targetX = group.targetAccel.x.data();
+	const float* __restrict targetY = group.targetAccel.y.data();
+	const float* __restrict targetZ = group.targetAccel.z.data();
+	const float* __restrict jerk = group.jerk.data();
+	const float* __restrict jerkDecelRate = group.jerkDecelRate.data();
+	const uint8_t* __restrict accelerating = group.accelerating.data();
+
+	for (size_t i = begin; i < end; ++i)
+	{
+		SFlightVec3 current(currentX[i], currentY[i], currentZ[i]);
+		CFlightModel::StepJerk(current, SFlightVec3(targetX[i], targetY[i], targetZ[i]), jerk[i], jerkDecelRate[i], accelerating[i] != 0, frameTime);
+
+		currentX[i] = current.x;
+		currentY[i] = current.y;
+		currentZ[i] = current.z;
+	}
+}
@@ -0,0 +1,82 @@
+// Copyright 2017-2021 Crytek GmbH / Crytek Group. All rights reserved.
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <Components/FlightModel.h>
+
+////////////////////////////////////////////////////////
+// Jerk state and impulse scales of many ships, stored as structure-of-arrays and stepped together.
+// No engine dependency: the flight system drives one for the game, the headless model one for the benchmark and the replayer.
+////////////////////////////////////////////////////////
+class CFlightBatch
+{
+public:
+	using SlotId = uint32_t;
+
+	void Resize(size_t size);
+	size_t GetSize() const { return m_mass.size(); }
+
+	// Per ship parameters
+	void SetJerkRates(SlotId slot, EJerkGroup group, float jerk, float jerkDecelRate);
+	void ResetJerk(SlotId slot);
+	void SetImpulseScale(SlotId slot, float mass, float linearScale, float angularScale);
+
+	void SetTargetAccel(SlotId slot, EJerkGroup group, const SFlightVec3& targetAccel, EAccelState state);
+	EAccelState GetAccelState(SlotId slot, EJerkGroup group) const;
+
+	void SetCurrentAccel(SlotId slot, EJerkGroup group, const SFlightVec3& currentAccel);
+	SFlightVec3 GetCurrentAccel(SlotId slot, EJerkGroup group) const;
+
+	// Copy of the jerk state of a group, safe to use for simulated (math only) calculations
+	JerkAccelerationData GetJerkData(SlotId slot, EJerkGroup group) const;
+	std::array<JerkAccelerationData, (size_t)EJerkGroup::Count> GetJerkData(SlotId slot) const;
+
+	// Copies one slot from another batch: the gathered inputs (jerk rates, targets, impulse scales), or the integrated accelerations.
+	// Lets a second thread step its own batch (CFlightSystem physics step mode).
+	void CopyInputs(const CFlightBatch& source, SlotId slot);
+	void CopyCurrentAccel(const CFlightBatch& source, SlotId slot);
+
+	// Integrates the jerk state and computes the impulses of every slot, or of [begin, end)
+	void Step(float frameTime) { StepRange(frameTime, 0, GetSize()); }
+	void StepRange(float frameTime, size_t begin, size_t end);
+
+	// Impulses of the last step
+	SFlightVec3 GetLinearImpulse(SlotId slot) const { return m_linearImpulse.Get(slot); }
+	SFlightVec3 GetAngularImpulse(SlotId slot) const { return m_angularImpulse.Get(slot); }
+
+private:
+	struct SVec3Array
+	{
+		std::vector<float> x;
+		std::vector<float> y;
+		std::vector<float> z;
+
+		void Resize(size_t size) { x.resize(size, 0.f); y.resize(size, 0.f); z.resize(size, 0.f); }
+		void Set(size_t i, const SFlightVec3& value) { x[i] = value.x; y[i] = value.y; z[i] = value.z; }
+		SFlightVec3 Get(size_t i) const { return SFlightVec3(x[i], y[i], z[i]); }
+	};
+
+	struct SJerkGroupArrays
+	{
+		SVec3Array currentAccel;
+		SVec3Array targetAccel;
+		std::vector<float> jerk;
+		std::vector<float> jerkDecelRate;
+		std::vector<uint8_t> accelerating; // EAccelState::Accelerating, kept as a byte mask for branchless loops
+
+		void Resize(size_t size);
+	};
+
+	void StepJerkGroup(SJerkGroupArrays& group, float frameTime, size_t begin, size_t end);
+
+	std::array<SJerkGroupArrays, (size_t)EJerkGroup::Count> m_jerkGroups;
+
+	std::vector<float> m_mass;
+	std::vector<float> m_linearScale;
+	std::vector<float> m_angularScale;
+
+	SVec3Array m_linearImpulse;
+	SVec3Array m_angularImpulse;
+};
@@ -12,11 +12,15 @@
 #include <CryEntitySystem/IEntityComponent.h>
 #include <CryNetwork/ISerialize.h>
 #include <CryNetwork/Rmi.h>
+#include <IGameFramework.h>
 
 // Forward declaration
 #include <DefaultComponents/Input/InputComponent.h>
+#include <DefaultComponents/Geometry/StaticMeshComponent.h>
 #include <Components/VehicleComponent.h>
+#include <Components/FlightRecorder.h>
 #include <Components/Player.h>
+#include <Components/ShipThrusterComponent.h>
 
 
 // Registers the component to be used in the engine
@@ -40,18 +44,34 @@ void CFlightController::Initialize()
 
 	GetEntity()->GetNetEntity()->EnableDelegatableAspect(eEA_GameClientA, false);
 
-	SRmi<RMI_WRAP(&CFlightController::RequestImpulseOnServer)>::Register(this, eRAT_Urgent, false, eNRT_ReliableOrdered);
-	SRmi<RMI_WRAP(&CFlightController::UpdateMovement)>::Register(this, eRAT_Urgent, false, eNRT_ReliableOrdered);
+	SRmi<RMI_WRAP(&CFlightController::RequestFlightCommands)>::Register(this, eRAT_NoAttach, false, eNRT_UnreliableUnordered);
 
 	GetEntity()->EnablePhysics(true);
-	GetEntity()->PhysicsNetSerializeEnable(true);
+	// The ship state is replicated by CShipReplication, engine physics sync would fight the client prediction
+	GetEntity()->PhysicsNetSerializeEnable(false);
 	GetEntity()->GetNetEntity()->BindToNetwork();
+
+	// Thrusters initialized before us could not register yet
+	DynArray<CShipThrusterComponent*> thrusters;
+	m_pEntity->GetAllComponents<CShipThrusterComponent>(thrusters);
+	for (CShipThrusterComponent* pThruster : thrusters)
+	{
+		RegisterThruster(pThruster);
+	}
+}
+
+CFlightController::~CFlightController()
+{
+	if (m_flightSlot != CFlightSystem::kInvalidSlot)
+	{
+		CFlightSystem::GetInstance().UnregisterShip(m_flightSlot);
+	}
 }
 
 Cry::Entity::EventFlags CFlightController::GetEventMask() const
 {
-	//Listening to the update event
-	return EEntityEvent::Update | EEntityEvent::GameplayStarted;
+	// Updates are driven by the flight system, we only need to know when to register
+	return EEntityEvent::GameplayStarted;
 }
 
 void CFlightController::ProcessEvent(const SEntityEvent& event)
@@ -60,22 +80,122 @@ void CFlightController::ProcessEvent(const SEntityEvent& event)
 	{
 	case EEntityEvent::GameplayStarted:
 	{
+		if (m_flightSlot == CFlightSystem::kInvalidSlot)
+		{
+			m_flightSlot = CFlightSystem::GetInstance().RegisterShip(this);
+		}
 		ResetJerkParams();
+		InitializeMotionParamsVectors();
 		InitializeJerkParams();
 		physEntity = m_pEntity->GetPhysicalEntity();
-		InitializeMotionParamsVectors();
 	}
 	break;
-	case EEntityEvent::Update:
+	}
+}
+
+bool CFlightController::PrepareFlightStep(float frameTime)
+{
+	m_frameTime = frameTime;
+	m_applyFlightImpulse = false;
+	m_applyModifiers = false;
+	m_drawFlightDebug = false;
+
+	if (!m_pVehicleComponent->GetIsPiloting())
+	{
+		// The pilot left, whatever it still had queued is not flown
+		if (m_remoteInputs.HasInputs())
+			m_remoteInputs.Reset();
+	}
+	else if (m_remoteInputs.Consume(m_inputSequence, m_remoteInput))
+	{
+		// Server side: the input of a remote pilot for this step goes through the same flight modes, with this ship's profile
+		m_shipInput = m_remoteInput.Unpack();
+		UpdateKinematics();
+		m_activeModifiers = GetFlightModifierState();
+		m_applyFlightImpulse = FlightModifierHandler(m_kinematics, m_activeModifiers, frameTime);
+		m_applyModifiers = true;
+	}
+	else
 	{
-		m_frameTime = event.fParam[0];
-		if (m_pVehicleComponent->GetIsPiloting())
+		// Only the machine of the pilot reads input, the server receives it through RequestFlightCommands
+		if (!IsLocallyPiloted())
+			return false;
+
+		m_shipInput = GetPilot()->GetShipInput();
+		NormalizeInput(m_shipInput);
+		UpdateKinematics();
+
+		if (!gEnv->bServer)
 		{
-			ResetImpulseCounter();
-			FlightModifierHandler(GetFlightModifierState(), m_frameTime);
+			// The previous step has been simulated by now, correct it if the server disagrees before predicting the next one
+			StorePredictionResult();
+			Reconcile();
+			++m_inputSequence;
+			QueueFlightCommand();
+		}
+
+		// After the reconciliation, the state the step starts from is the one the replay starts from
+		RecordFlightInput(frameTime);
+
+		ResetImpulseCounter();
+		m_drawFlightDebug = true;
+		m_activeModifiers = GetFlightModifierState();
+		m_applyFlightImpulse = FlightModifierHandler(m_kinematics, m_activeModifiers, frameTime);
+		m_applyModifiers = true;
+
+		if (!gEnv->bServer)
+		{
+			RecordPrediction(frameTime);
+			SendFlightCommands(frameTime);
 		}
 	}
-	break;
+
+	if (m_applyFlightImpulse)
+	{
+		const float linearScale = CFlightModel::GetLinearScale(m_profile, m_activeModifiers);
+		const float angularScale = CFlightModel::GetAngularScale(m_profile, m_activeModifiers);
+		CFlightSystem::GetInstance().SetImpulseScale(m_flightSlot, m_kinematics.mass, linearScale, angularScale);
+	}
+
+	return m_applyFlightImpulse || m_applyModifiers;
+}
+
+void CFlightController::CommitFlightStep(const Vec3& linearImpulse, const Vec3& angularImpulse, float frameTime)
+{
+	if (m_applyFlightImpulse)
+	{
+		ApplyImpulse(linearImpulse, angularImpulse);
+	}
+
+	CommitFlightModifiers(frameTime);
+	CommitWrench();
+}
+
+void CFlightController::CommitFlightModifiers(float frameTime)
+{
+	const bool antiGravity = m_applyModifiers && m_activeModifiers.HasFlag(EFlightModifierFlag::Gravity);
+	const Vec3 antiGravityForce = antiGravity ? GetAntiGravityForce(m_kinematics) : Vec3(ZERO);
+
+	// In physics step mode the force is held over every substep, as part of the flight impulse
+	CFlightSystem& flightSystem = CFlightSystem::GetInstance();
+	if (flightSystem.IsPhysicsStepActive())
+	{
+		flightSystem.SetHoldForce(m_flightSlot, antiGravityForce);
+	}
+	else if (antiGravity)
+	{
+		AddImpulse(antiGravityForce * frameTime, Vec3(ZERO));
+	}
+
+	if (m_applyModifiers)
+	{
+
+		// Debug stuff - Includes 2d velocity vector display. Only on the pilot's machine, the server has no one to show it to
+		if (m_drawFlightDebug)
+		{
+			gEnv->pAuxGeomRenderer->Draw2dLabel(50, 180, 2, m_debugColor, false, "(G) Anti-Gravity: %s", antiGravity ? "ON" : "OFF");
+			DrawOnScreenDebugText(m_kinematics, frameTime);
+		}
 	}
 }
 
@@ -84,43 +204,48 @@ void CFlightController::ProcessEvent(const SEntityEvent& event)
 ///////////////////////////////////////////////////////////////////////////
 void CFlightController::InitializeJerkParams()
 {
-	m_linearJerkData.jerk = m_linearJerkRate;
-	m_linearJerkData.jerkDecelRate = m_linearJerkDecelRate;
-	m_rollJerkData.jerk = m_RollJerkRate;
-	m_rollJerkData.jerkDecelRate = m_RollJerkDecelRate;
-	m_pitchYawJerkData.jerk = m_PitchYawJerkRate;
-	m_pitchYawJerkData.jerkDecelRate = m_PitchYawJerkDecelRate;
+	CFlightSystem& flightSystem = CFlightSystem::GetInstance();
+	for (size_t group = 0; group < (size_t)EJerkGroup::Count; ++group)
+	{
+		flightSystem.SetJerkRates(m_flightSlot, (EJerkGroup)group, m_profile.jerk[group], m_profile.jerkDecelRate[group]);
+	}
 }
 
 void CFlightController::ResetJerkParams()
 {
-	m_linearJerkData.currentJerkAccel = Vec3(ZERO);
-	m_rollJerkData.currentJerkAccel = Vec3(ZERO);
-	m_pitchYawJerkData.currentJerkAccel = Vec3(ZERO);
-	m_linearJerkData.targetJerkAccel = Vec3(ZERO);
-	m_rollJerkData.targetJerkAccel = Vec3(ZERO);
-	m_pitchYawJerkData.targetJerkAccel = Vec3(ZERO);
+	CFlightSystem::GetInstance().ResetJerk(m_flightSlot);
 }
 
 void CFlightController::InitializeMotionParamsVectors()
 {
-	// Initializing the maps of the motion profile
-	m_linearParamsMap[AxisType::Linear] = {
-		{"accel_forward", m_fwdAccel, m_maxFwdVel,  Vec3(0.f, 1.f, 0.f)},
-		{"accel_backward", m_bwdAccel, m_maxBwdVel, Vec3(0.f, -1.f, 0.f)},
-		{"accel_left", m_leftRightAccel, m_maxLatVel, Vec3(-1.f, 0.f, 0.f)},
-		{"accel_right", m_leftRightAccel, m_maxLatVel, Vec3(1.f, 0.f, 0.f)},
-		{"accel_up", m_upDownAccel, m_maxUpDownVel, Vec3(0.f, 0.f, 1.f)},
-		{"accel_down", m_upDownAccel, m_maxUpDownVel, Vec3(0.f, 0.f, -1.f)}
-	};
-	m_rollParamsMap[AxisType::Roll] = {
-		{"roll_left", DEG2RAD(m_rollAccel), DEG2RAD(m_maxRoll), Vec3(0.f, -1.f, 0.f)},
-		{"roll_right", DEG2RAD(m_rollAccel), DEG2RAD(m_maxRoll), Vec3(0.f, 1.f, 0.f)}
-	};
-	m_pitchYawParamsMap[AxisType::PitchYaw] = {
-		{"yaw", DEG2RAD(m_yawAccel), DEG2RAD(m_maxYaw), Vec3(0.f, 0.f, -1.f)},
-		{"pitch", DEG2RAD(m_pitchAccel), DEG2RAD(m_maxPitch), Vec3(-1.f, 0.f, 0.f)}
+	// Initializing the axes of the motion profile
+	const auto setAxis = [this](EShipAxis axis, EJerkGroup group, float accel, float velocityLimit, const SFlightVec3& localDirection)
+	{
+		SFlightAxis& profileAxis = m_profile.axes[(size_t)axis];
+		profileAxis.group = group;
+		profileAxis.accel = accel;
+		profileAxis.velocityLimit = velocityLimit;
+		profileAxis.localDirection = localDirection;
 	};
+
+	setAxis(EShipAxis::AccelForward, EJerkGroup::Linear, m_fwdAccel, m_maxFwdVel, SFlightVec3(0.f, 1.f, 0.f));
+	setAxis(EShipAxis::AccelBackward, EJerkGroup::Linear, m_bwdAccel, m_maxBwdVel, SFlightVec3(0.f, -1.f, 0.f));
+	setAxis(EShipAxis::AccelLeft, EJerkGroup::Linear, m_leftRightAccel, m_maxLatVel, SFlightVec3(-1.f, 0.f, 0.f));
+	setAxis(EShipAxis::AccelRight, EJerkGroup::Linear, m_leftRightAccel, m_maxLatVel, SFlightVec3(1.f, 0.f, 0.f));
+	setAxis(EShipAxis::AccelUp, EJerkGroup::Linear, m_upDownAccel, m_maxUpDownVel, SFlightVec3(0.f, 0.f, 1.f));
+	setAxis(EShipAxis::AccelDown, EJerkGroup::Linear, m_upDownAccel, m_maxUpDownVel, SFlightVec3(0.f, 0.f, -1.f));
+	setAxis(EShipAxis::RollLeft, EJerkGroup::Roll, DEG2RAD(m_rollAccel), DEG2RAD(m_maxRoll), SFlightVec3(0.f, -1.f, 0.f));
+	setAxis(EShipAxis::RollRight, EJerkGroup::Roll, DEG2RAD(m_rollAccel), DEG2RAD(m_maxRoll), SFlightVec3(0.f, 1.f, 0.f));
+	setAxis(EShipAxis::Yaw, EJerkGroup::PitchYaw, DEG2RAD(m_yawAccel), DEG2RAD(m_maxYaw), SFlightVec3(0.f, 0.f, -1.f));
+	setAxis(EShipAxis::Pitch, EJerkGroup::PitchYaw, DEG2RAD(m_pitchAccel), DEG2RAD(m_maxPitch), SFlightVec3(-1.f, 0.f, 0.f));
+
+	m_profile.jerk = { m_linearJerkRate, m_RollJerkRate, m_PitchYawJerkRate };
+	m_profile.jerkDecelRate = { m_linearJerkDecelRate, m_RollJerkDecelRate, m_PitchYawJerkDecelRate };
+	m_profile.linearBoost = m_linearBoost;
+	m_profile.angularBoost = m_angularBoost;
+	m_profile.logBase = m_linearLogBase;
+	m_profile.logMaxDiscrepancy = m_linearLogMaxDiscrepancy;
+	m_profile.correctionLookahead = m_correctionLookahead;
 }
 
 pe_status_dynamics CFlightController::GetDynamics()
@@ -137,25 +262,83 @@ pe_status_dynamics CFlightController::GetDynamics()
 	return pe_status_dynamics(); // Ensure a valid return type
 }
 
-FlightModifierBitFlag CFlightController::GetFlightModifierState()
+void CFlightController::UpdateKinematics()
 {
-	return m_pVehicleComponent->m_pPlayerComponent->GetComponent<CPlayerComponent>()->GetFlightModifierState();
+	// The only physics query of the flight step
+	const pe_status_dynamics dynamics = GetDynamics();
+
+	m_kinematics.velocity = dynamics.v;
+	m_kinematics.angularVelocity = dynamics.w;
+	m_kinematics.mass = dynamics.mass;
+	m_kinematics.orientation = m_pEntity->GetWorldRotation();
+	m_kinematics.localVelocity = m_kinematics.orientation.GetInverted() * dynamics.v;
+
+	m_kinematics.motion.velocity = ToFlightVec3(dynamics.v);
+	m_kinematics.motion.angularVelocity = ToFlightVec3(dynamics.w);
+	m_kinematics.motion.mass = dynamics.mass;
+
+	// Rotate every thruster axis of the motion profile into world space once
+	for (size_t axis = 0; axis < (size_t)EShipAxis::Count; ++axis)
+	{
+		m_kinematics.motion.thrusterDirections[axis] = ToFlightVec3(m_kinematics.orientation * ToVec3(m_profile.axes[axis].localDirection));
+	}
 }
 
-float CFlightController::AxisGetter(const string& axisName)
+void CFlightController::RecordFlightInput(float frameTime)
 {
-	if (m_pVehicleComponent->m_pPlayerComponent)
-		return m_pVehicleComponent->m_pPlayerComponent->GetComponent<CPlayerComponent>()->GetAxisValue(axisName);
-	else
-		return 0;
+	CFlightRecorder& recorder = CFlightRecorder::GetInstance();
+	if (!recorder.IsRecording())
+		return;
+
+	if (recorder.NeedsHeader())
+	{
+		const Quat orientation = m_kinematics.orientation;
+
+		SFlightLogHeader header;
+		header.profile = m_profile;
+		header.mass = m_kinematics.mass;
+		header.gravity = ToFlightVec3(gEnv->pPhysicalWorld->GetPhysVars()->gravity);
+		header.body.position = ToFlightVec3(m_pEntity->GetWorldPos());
+		header.body.orientation = { orientation.w, orientation.v.x, orientation.v.y, orientation.v.z };
+		header.body.velocity = m_kinematics.motion.velocity;
+		header.body.angularVelocity = m_kinematics.motion.angularVelocity;
+		header.jerk = CFlightSystem::GetInstance().GetJerkData(m_flightSlot);
+		recorder.RecordHeader(header);
+	}
+
+	recorder.RecordFrame(frameTime, m_shipInput);
+}
+
+FlightModifierBitFlag CFlightController::GetFlightModifierState() const
+{
+	return m_shipInput.modifiers;
 }
 
-Vec3 CFlightController::WorldToLocal(const Vec3& localDirection)
+CPlayerComponent* CFlightController::GetPilot() const
 {
-	Quat worldRotation = m_pEntity->GetWorldRotation();
-	Vec3 worldDirection = worldRotation * localDirection;
+	if (IEntity* pPilotEntity = m_pVehicleComponent->GetPlayerComponent())
+		return pPilotEntity->GetComponent<CPlayerComponent>();
+	return nullptr;
+}
+
+float CFlightController::AxisGetter(EShipAxis axis) const
+{
+	return m_shipInput.GetAxis(axis);
+}
+
+void CFlightController::NormalizeInput(SShipInputSnapshot& input) const
+{
+	for (size_t axis = 0; axis < (size_t)EShipAxis::Count; ++axis)
+	{
+		// Mouse sensitivity scaling for pitch and yaw
+		const SFlightAxis& profileAxis = m_profile.axes[axis];
+		const bool mouseScaling = profileAxis.group == EJerkGroup::PitchYaw;
+		input.axes[axis] = ClampInput(input.axes[axis], profileAxis.accel, mouseScaling);
+	}
 
-	return worldDirection;
+	SQuantizedShipInput quantized;
+	quantized.Pack(input);
+	input = quantized.Unpack();
 }
 
 float CFlightController::ClampInput(float inputValue, float maxAxisAccel, bool mouseScaling) const
@@ -175,150 +358,86 @@ float CFlightController::ClampInput(float inputValue, float maxAxisAccel, bool m
 ///////////////////////////////////////////////////////////////////////////
 // FLIGHT CALCULATIONS
 ///////////////////////////////////////////////////////////////////////////
-ScaledMotion CFlightController::ScaleInput(const VectorMap<AxisType, DynArray<AxisMotionParams>>& axisParamsList)
+void CFlightController::ApplyImpulse(const Vec3& linearImpulse, const Vec3& angImpulse)
 {
-	// Initializing vectors for acceleration direction and desired acceleration
-	Vec3 localDirection(ZERO); // Calculate local thrust direction based on input value
+	// Boost multipliers and CFlightModel::kImpulseGain were already applied by the flight system
+	Vec3 resolvedLinear, resolvedAngular;
+	ResolveImpulse(linearImpulse, angImpulse, m_kinematics.orientation, m_frameTime, resolvedLinear, resolvedAngular);
+	m_wrench.Add(resolvedLinear, resolvedAngular);
 
-	// Vectors to accumulate the directions of the requested accelerations and velocities by the input magnitude.
-	Vec3 requestedAccelDirection(ZERO), requestedVelDirection(ZERO);
-	
-	for (const auto& axisMotionParamsPair : axisParamsList)	// Iterating over the list of axis and their input values
-	{
-		AxisType axisType = axisMotionParamsPair.first;
-		const DynArray<AxisMotionParams>& axisMotionParamsArray = axisMotionParamsPair.second;
-
-		for (const auto& motionParams : axisMotionParamsArray)	// Iterate over the DynArray<AxisAccelParams> for the current Axis
-		{
-			float clampedInput(ZERO); // Clamping or normalizing input values
-			if (axisType == AxisType::PitchYaw)
-			{
-				// Applying a mouse sentitivity scaling for pitch and yaw, if it is enabled
-				clampedInput = ClampInput(AxisGetter(motionParams.axisName), motionParams.AccelAmount, true); // Retrieve input value for the current axis and clamp to a range of -1 to 1
-			}
-			else
-				clampedInput = ClampInput(AxisGetter(motionParams.axisName), motionParams.AccelAmount);
-
-			localDirection = WorldToLocal(motionParams.localDirection); // Convert to local space
-			
-			requestedAccelDirection += localDirection * motionParams.AccelAmount * clampedInput; // Accumulate axis direction, scaling each by its input magnitude in local space
-			
-			requestedVelDirection += localDirection * motionParams.velocityLimit * clampedInput; // Accumulate desired velocity based on thrust direction and input value
-		}
-	}
-	return ScaledMotion(requestedAccelDirection, requestedVelDirection);   // Return the scaled acceleration direction vector in m/s
+	// Update our impulse tracking variables to send over to the server
+	m_linearImpulse = linearImpulse;
+	m_angularImpulse = angImpulse;
 }
 
-void CFlightController::UpdateAccelerationState(JerkAccelerationData& accelData, const Vec3& targetAccel)
+void CFlightController::ResolveImpulse(const Vec3& linearImpulse, const Vec3& angImpulse, const Quat& orientation, float frameTime, Vec3& outLinear, Vec3& outAngular)
 {
-	accelData.targetJerkAccel = targetAccel;
-	if (targetAccel.IsZero())
-	{
-		accelData.state = EAccelState::Decelerating;
-	}
-	else
+	// The physics step applies the flight system's impulse as is: its substeps run on the physics thread, where the thruster
+	// components can not be throttled. Ships with thrusters fly on the ideal wrench there (flight_physicsStep, single player only).
+	if (CFlightSystem::GetInstance().IsPhysicsStepActive() || !m_thrusterAllocator.HasAuthority() || frameTime <= 0.f)
 	{
-		accelData.state = EAccelState::Accelerating;
+		outLinear = linearImpulse;
+		outAngular = angImpulse;
+		return;
 	}
-}
 
-Vec3 CFlightController::UpdateAccelerationWithJerk(AxisType axisType, JerkAccelerationData& accelData, float frameTime) const
-{
-	// Calculate the difference between current and target acceleration
-	Vec3 deltaAccel = accelData.targetJerkAccel - accelData.currentJerkAccel;
-	Vec3 finalJerk;
+	// Thrusters are laid out in ship space and rated in newtons
+	const Quat worldToLocal = orientation.GetInverted();
+	Vec3 achievedForce, achievedTorque;
+	m_thrusterAllocator.Allocate(worldToLocal * linearImpulse / frameTime, worldToLocal * angImpulse / frameTime, achievedForce, achievedTorque);
 
-	// Determine jerk rate based on acceleration state
-	switch (accelData.state)
-	{
-	case EAccelState::Accelerating:
-	{
-		float scale = powf(fabs(deltaAccel.GetLength()), 0.3f);
-		finalJerk = deltaAccel * scale * accelData.jerk * frameTime;
-		break;
-	}
-	case EAccelState::Decelerating:
-	{
-		finalJerk = deltaAccel * accelData.jerkDecelRate * frameTime;
-		break;
-	}
-	}
-
-	// Update current acceleration
-	Vec3 newAccel = accelData.currentJerkAccel + finalJerk; // Calculate new acceleration by adding jerk to current acceleration
-
-	return newAccel; // Return the updated acceleration
+	outLinear = orientation * achievedForce * frameTime;
+	outAngular = orientation * achievedTorque * frameTime;
 }
 
-ImpulseResult CFlightController::AccelToImpulse(const MotionData& motionData, float frameTime, bool mathOnly)
+void CFlightController::RegisterThruster(CShipThrusterComponent* pThruster)
 {
-	pe_status_dynamics dynamics = GetDynamics();
-
-	Vec3 linearImpulse = Vec3(ZERO);
-	Vec3 angImpulse = Vec3(ZERO);
-
-	// Pointer to the motion data to use, either original or simulated
-	const MotionData* pMotionData = &motionData;
-	MotionData simulatedMotionData;
-
-	if (mathOnly)
-	{
-		// Create a copy of motionData to work with if mathOnly is true
-		simulatedMotionData = motionData;
-		// pMotionData will point to the copy if we are simulating an impulse, not affecting the proper data.
-		pMotionData = &simulatedMotionData;
-	}
-
-	// Infuse the acceleration value with the current jerk coefficient
-	pMotionData->linearJerkData->targetJerkAccel = pMotionData->linearAccel;
-	pMotionData->linearJerkData->currentJerkAccel = UpdateAccelerationWithJerk(AxisType::Linear, *pMotionData->linearJerkData, frameTime);
-
-	pMotionData->rollJerkData->targetJerkAccel = pMotionData->rollAccel;
-	pMotionData->rollJerkData->currentJerkAccel = UpdateAccelerationWithJerk(AxisType::Roll, *pMotionData->rollJerkData, frameTime);
-
-	pMotionData->pitchYawJerkData->targetJerkAccel = pMotionData->pitchYawAccel;
-	pMotionData->pitchYawJerkData->currentJerkAccel = UpdateAccelerationWithJerk(AxisType::PitchYaw, *pMotionData->pitchYawJerkData, frameTime);
-
-	// Calculate impulses based on the jerk data
-	linearImpulse = pMotionData->linearJerkData->currentJerkAccel * dynamics.mass * frameTime;
-	angImpulse = (pMotionData->rollJerkData->currentJerkAccel + pMotionData->pitchYawJerkData->currentJerkAccel) * dynamics.mass * frameTime;
+	m_thrusterAllocator.AddThruster(pThruster);
+}
 
-	ApplyImpulse(linearImpulse, angImpulse, mathOnly);
+void CFlightController::UnregisterThruster(CShipThrusterComponent* pThruster)
+{
+	m_thrusterAllocator.RemoveThruster(pThruster);
+}
 
-	return ImpulseResult(linearImpulse, angImpulse);
+void CFlightController::OnThrusterLayoutChanged()
+{
+	m_thrusterAllocator.MarkDirty();
 }
 
+void CFlightController::AddImpulse(const Vec3& linearImpulse, const Vec3& angularImpulse)
+{
+	m_wrench.Add(linearImpulse, angularImpulse);
+}
 
-void CFlightController::ApplyImpulse(Vec3 linearImpulse, Vec3 angImpulse, bool mathOnly)
+void CFlightController::CommitWrench()
 {
+	if (m_wrench.IsZero())
+		return;
 
 	IPhysicalEntity* pPhysicalEntity = GetEntity()->GetPhysics();
 	if (pPhysicalEntity)
 	{
-		pe_action_impulse actionImpulse;
-
-		if (m_isBoosting)
+		CFlightSystem& flightSystem = CFlightSystem::GetInstance();
+		if (flightSystem.IsPhysicsStepActive())
 		{
-			linearImpulse *= m_linearBoost;
-			angImpulse *= m_angularBoost;
+			// Merged into the next substep's flight action
+			flightSystem.QueueImpulse(m_flightSlot, m_wrench.linearImpulse, m_wrench.angularImpulse);
 		}
-		actionImpulse.impulse = linearImpulse;
-		actionImpulse.angImpulse = angImpulse;
-
-
-		// Apply linear and angular impulse
-		if (!mathOnly)
+		else
 		{
+			pe_action_impulse actionImpulse;
+			actionImpulse.impulse = m_wrench.linearImpulse;
+			actionImpulse.angImpulse = m_wrench.angularImpulse;
 			pPhysicalEntity->Action(&actionImpulse);
-			pPhysicalEntity->Action(&actionImpulse);
-			Vec3 impulse = (actionImpulse.impulse + actionImpulse.angImpulse) / m_frameTime; // Revert the frametime scaling to have the proper values
-			m_totalImpulse += impulse.GetLength();
 		}
 
-		// Update our impulse tracking variables to send over to the server
-		m_linearImpulse = linearImpulse;
-		m_angularImpulse = actionImpulse.angImpulse;
+		// Revert the frametime scaling to have the proper values
+		if (m_frameTime > 0.f)
+			m_totalImpulse += (m_wrench.linearImpulse.GetLength() + m_wrench.angularImpulse.GetLength()) / m_frameTime;
 	}
+
+	m_wrench.Clear();
 }
 
 float CFlightController::GetImpulse() const
@@ -331,20 +450,16 @@ void CFlightController::ResetImpulseCounter()
 	m_totalImpulse = 0.f;
 }
 
-Vec3 CFlightController::GetVelocity()
+Vec3 CFlightController::GetVelocity(const SFlightKinematics& kinematics) const
 {
-	pe_status_dynamics dynamics = GetDynamics();
-
-	Vec3 velocity = dynamics.v; // In world space 
-	Matrix34 worldToLocalMatrix = m_pEntity->GetWorldTM().GetInverted();
-
-	return worldToLocalMatrix.TransformVector(velocity);
+	// Rotated into ship space when the kinematics were gathered
+	return kinematics.localVelocity;
 }
 
-float CFlightController::GetAcceleration(float frameTime)
+float CFlightController::GetAcceleration(const SFlightKinematics& kinematics, float frameTime)
 {
 	float acceleration = 0.f;
-	m_shipVelocity.currentVelocity = GetVelocity().GetLength();
+	m_shipVelocity.currentVelocity = GetVelocity(kinematics).GetLength();
 	float deltaV = m_shipVelocity.currentVelocity - m_shipVelocity.previousVelocity;
 	m_shipVelocity.previousVelocity = m_shipVelocity.currentVelocity;
 
@@ -353,195 +468,97 @@ float CFlightController::GetAcceleration(float frameTime)
 	return acceleration;
 }
 
-VelocityDiscrepancy CFlightController::CalculateDiscrepancy(Vec3 desiredVelocity)
+void CFlightController::SetPostStepMonitoring(bool enable)
 {
-	pe_status_dynamics dynamics = GetDynamics();
+	if (m_monitorsPostStep == enable)
+		return;
 
-	Vec3 linearDiscrepancy = desiredVelocity - dynamics.v;
-	Vec3 angularDiscrepancy = desiredVelocity - dynamics.w;
+	IPhysicalEntity* pPhysicalEntity = m_pEntity->GetPhysicalEntity();
+	if (!pPhysicalEntity)
+		return;
 
-	// Compute the discrepancy for each axis
-	return VelocityDiscrepancy(linearDiscrepancy, angularDiscrepancy);
+	pe_params_flags flags;
+	if (enable)
+		flags.flagsOR = pef_monitor_poststep;
+	else
+		flags.flagsAND = ~pef_monitor_poststep;
+
+	pPhysicalEntity->SetParams(&flags);
+	m_monitorsPostStep = enable;
 }
 
-float CFlightController::LogScale(float discrepancyMagnitude, float maxDiscrepancy, float base)
-{
-	if (discrepancyMagnitude == 0.0f)
-		return 0.0f;
+///////////////////////////////////////////////////////////////////////////
+// PRESENTATION
+///////////////////////////////////////////////////////////////////////////
 
-	float logDiscrepancy = std::log(discrepancyMagnitude + 1.0f) / std::log(base);
-	float logMaxDiscrepancy = std::log(maxDiscrepancy + 1.0f) / std::log(base);
+void CFlightController::RecordFlightPose()
+{
+	m_previousFlightPose = m_currentFlightPose;
+	m_currentFlightPose = QuatT(m_pEntity->GetWorldPos(), m_pEntity->GetWorldRotation());
 
-	return logDiscrepancy / logMaxDiscrepancy;
+	// First tick, nothing to interpolate from yet
+	if (!m_hasFlightPose)
+	{
+		m_previousFlightPose = m_currentFlightPose;
+		m_hasFlightPose = true;
+	}
 }
 
-Vec3 CFlightController::CalculateCorrection(const VectorMap<AxisType, DynArray<AxisMotionParams>>& axisAccelParamsMap, Vec3 requestedVelocity, Vec3 velDiscrepancy)
+void CFlightController::UpdatePresentation(float alpha)
 {
-	pe_status_dynamics dynamics = GetDynamics();
-
-	Vec3 totalCorrectiveAccel = Vec3(ZERO);
-	Vec3 predictedVelocity = Vec3(ZERO);
-	float overshootFactor = 1.f;
-
-	// Calculate the magnitude of the velocity discrepancy
-	float discrepancyMagnitude = velDiscrepancy.GetLength();
-
-	const float maxDiscrepancy = m_linearLogMaxDiscrepancy;
-	const float base = m_linearLogBase;
+	if (!m_hasFlightPose)
+		return;
 
-	// Calculate the velocity scaling factor using logarithmic scaling
-	float scalingFactor = LogScale(discrepancyMagnitude, maxDiscrepancy, base);
-
-	// Ensure the scaling factor does not exceed 1.0
-	scalingFactor = std::min(scalingFactor, 1.0f);
-
-	// Initializing motionData for simulated calculation
-	MotionData motionData(
-		Vec3(ZERO),
-		Vec3(ZERO),
-		Vec3(ZERO),
-		&m_linearJerkData,
-		&m_rollJerkData,
-		&m_pitchYawJerkData
-	);
-
-	// Handle Linear Correction
-	for (const auto& axisAccelParamsPair : axisAccelParamsMap)
+	// The mesh slots are offset from the transform they were given, remember it before the first offset
+	if (!m_hasPresentationOffset)
 	{
-		AxisType axisType = axisAccelParamsPair.first;
+		m_presentedSlots.clear();
 
-		const DynArray<AxisMotionParams>& axisParamsArray = axisAccelParamsPair.second;
-		for (const auto& accelParams : axisParamsArray)
+		DynArray<Cry::DefaultComponents::CStaticMeshComponent*> meshes;
+		m_pEntity->GetAllComponents<Cry::DefaultComponents::CStaticMeshComponent>(meshes);
+		for (Cry::DefaultComponents::CStaticMeshComponent* pMesh : meshes)
 		{
-			Vec3 localDirection = WorldToLocal(accelParams.localDirection).GetNormalized();
-			float alignment = localDirection.Dot(velDiscrepancy.GetNormalized());
-
-			Vec3 correction = accelParams.AccelAmount * localDirection * alignment * scalingFactor;
-			totalCorrectiveAccel += correction;
-
-			// Predicting velocity to account for overshoot and calculating logarithmic velocity scaling for smoother motion
-			if (axisType == AxisType::Linear)
-			{
-				motionData.linearAccel = totalCorrectiveAccel;
-				Vec3 simulatedAccel = AccelToImpulse(motionData, m_frameTime, true).GetLinearImpulse();
-				// Predict future velocity based on current acceleration and jerk
-				predictedVelocity = dynamics.v + simulatedAccel; // Use the current acceleration for prediction
-			}
-			else if (axisType == AxisType::Roll)
-			{
-				motionData.rollAccel = totalCorrectiveAccel;
-				Vec3 simulatedAccel = AccelToImpulse(motionData, m_frameTime, true).GetAngularImpulse();
-				// Predict future velocity based on current acceleration and jerk
-				predictedVelocity = dynamics.w + simulatedAccel;
-			}
-			else if (axisType == AxisType::PitchYaw)
-			{
-				motionData.pitchYawAccel = totalCorrectiveAccel;
-				Vec3 simulatedAccel = AccelToImpulse(motionData, m_frameTime, true).GetAngularImpulse();
-				// Predict future velocity based on current acceleration and jerk
-				predictedVelocity = dynamics.w + simulatedAccel;
-			}
+			const int slot = pMesh->GetEntitySlotId();
+			if (slot != EmptySlotId)
+				m_presentedSlots.push_back({ slot, m_pEntity->GetSlotLocalTM(slot, false) });
 		}
+		m_hasPresentationOffset = true;
 	}
 
-	float targetVelocityLength = requestedVelocity.GetLength();
-
-	// Calculate overshoot factor based on predicted velocity
-	if (predictedVelocity.GetLength() > targetVelocityLength + 0.1f)
-	{
-		overshootFactor = targetVelocityLength / predictedVelocity.GetLength();
-
-		// Scale total corrective acceleration by the overshoot factor
-		totalCorrectiveAccel *= overshootFactor;
-	}
-
-	return totalCorrectiveAccel;
-}
-
-///////////////////////////////////////////////////////////////////////////
-// FLIGHT MODES 
-///////////////////////////////////////////////////////////////////////////
-
-void CFlightController::DirectInput(float frameTime)
-{
-	gEnv->pAuxGeomRenderer->Draw2dLabel(50, 30, 2, m_debugColor, false, "(V) Newtonian");
-
-
-	Vec3 linearAccelMagnitude = ScaleInput(m_linearParamsMap).GetAcceleration();
-	Vec3 rollAccelMagnitude = ScaleInput(m_rollParamsMap).GetAcceleration();
-	Vec3 pitchYawMagnitude = ScaleInput(m_pitchYawParamsMap).GetAcceleration();
+	QuatT presentedPose;
+	presentedPose.SetNLerp(m_previousFlightPose, m_currentFlightPose, alpha);
 
-
-	// Updates our current requested motion state to compute jerk accordingly (based on input, not ship motion!)
-	UpdateAccelerationState(m_linearJerkData, linearAccelMagnitude);
-	UpdateAccelerationState(m_rollJerkData, rollAccelMagnitude);
-	UpdateAccelerationState(m_pitchYawJerkData, pitchYawMagnitude);
-
-	MotionData motionData(linearAccelMagnitude, rollAccelMagnitude,
-		pitchYawMagnitude, &m_linearJerkData, &m_rollJerkData, &m_pitchYawJerkData);
-
-	// Send movement data to the server if we are connected, apply locally if not
-	if (!gEnv->bServer)
+	// Physics keeps the real transform, only the geometry is offset to the interpolated pose
+	const QuatT entityPose(m_pEntity->GetWorldPos(), m_pEntity->GetWorldRotation());
+	const Matrix34 offset(entityPose.GetInverted() * presentedPose);
+	for (const SPresentedSlot& presentedSlot : m_presentedSlots)
 	{
-		SRmi<RMI_WRAP(&CFlightController::RequestImpulseOnServer)>::InvokeOnServer(this, SerializeImpulseData{
-		Vec3(ZERO),
-		Quat(ZERO),
-		linearAccelMagnitude,
-		rollAccelMagnitude,
-		pitchYawMagnitude });
+		m_pEntity->SetSlotLocalTM(presentedSlot.slot, offset * presentedSlot.localTM);
 	}
-	else 
-		AccelToImpulse(motionData, frameTime);
 }
 
-void CFlightController::CoupledFM(float frameTime)
+void CFlightController::ResetPresentation()
 {
-	gEnv->pAuxGeomRenderer->Draw2dLabel(50, 30, 2, m_debugColor, false, "(V) Coupled");
-
-	Vec3 linearVelMagnitude = ScaleInput(m_linearParamsMap).GetVelocity(); // Scale and set the target velocity for linear movement
-	Vec3 rollVelMagnitude = ScaleInput(m_rollParamsMap).GetVelocity();
-	Vec3 pitchYawVelMagnitude = ScaleInput(m_pitchYawParamsMap).GetVelocity();
+	m_hasFlightPose = false;
 
-	// Updates our current requested motion state to compute jerk accordingly (based on input, not ship motion!)
-	UpdateAccelerationState(m_linearJerkData, linearVelMagnitude);
-
-	// Calculates the velocity discrepancy between the current velocity and the requested
-	Vec3 linearDiscrepancy = CalculateDiscrepancy(linearVelMagnitude).GetLinearDiscrepancy();
-	Vec3 rollDiscrepancy = CalculateDiscrepancy(rollVelMagnitude).GetAngularDiscrepancy();
-	Vec3 pitchYawDiscrepancy = CalculateDiscrepancy(pitchYawVelMagnitude).GetAngularDiscrepancy();
-
-	// Calculates a correction, accounting for overshoot
-	Vec3 linearCorrection = CalculateCorrection(m_linearParamsMap, linearVelMagnitude, linearDiscrepancy);
-	Vec3 rollCorrection = CalculateCorrection(m_rollParamsMap, rollVelMagnitude , rollDiscrepancy);
-	Vec3 pitchYawCorrection = CalculateCorrection(m_pitchYawParamsMap, pitchYawVelMagnitude, pitchYawDiscrepancy);
-
-	// Setting up the motion parameters 
-	MotionData motionData(linearCorrection, rollCorrection,
-		pitchYawCorrection, &m_linearJerkData, &m_rollJerkData, &m_pitchYawJerkData);
-
-	// Send movement data to the server if we are connected, apply locally if not
-	if (!gEnv->bServer)
+	if (m_hasPresentationOffset)
 	{
-		SRmi<RMI_WRAP(&CFlightController::RequestImpulseOnServer)>::InvokeOnServer(this, SerializeImpulseData{
-		Vec3(ZERO),
-		Quat(ZERO),
-		linearCorrection,
-		rollCorrection,
-		pitchYawCorrection });
+		for (const SPresentedSlot& presentedSlot : m_presentedSlots)
+		{
+			m_pEntity->SetSlotLocalTM(presentedSlot.slot, presentedSlot.localTM);
+		}
+		m_presentedSlots.clear();
+		m_hasPresentationOffset = false;
 	}
-	else
-		AccelToImpulse(motionData, frameTime);
 }
 
 ///////////////////////////////////////////////////////////////////////////
 // DEBUG
 ///////////////////////////////////////////////////////////////////////////
 
-void CFlightController::DrawDirectionIndicator(float frameTime)
+void CFlightController::DrawDirectionIndicator(const SFlightKinematics& kinematics, float frameTime)
 {
-	pe_status_dynamics dynamics = GetDynamics();
-
-	Vec3 velocity = dynamics.v;
+	Vec3 velocity = kinematics.velocity;
 
 	// Transform the velocity vector to view | Other than direction, we need a 3D position to project onto the 2D screen.
 	const CCamera& camera = gEnv->pSystem->GetViewCamera();
@@ -565,165 +582,315 @@ void CFlightController::DrawDirectionIndicator(float frameTime)
 		gEnv->pAuxGeomRenderer->Draw2dLabel(screenX, screenY, 3.0f, m_debugColor, true, "x");
 }
 
-void CFlightController::DrawOnScreenDebugText(float frameTime)
+void CFlightController::DrawOnScreenDebugText(const SFlightKinematics& kinematics, float frameTime)
 {
-	gEnv->pAuxGeomRenderer->Draw2dLabel(50, 60, 2, m_debugColor, false, "Velocity: %.2f", GetVelocity().GetLength());
-	gEnv->pAuxGeomRenderer->Draw2dLabel(50, 90, 2, m_debugColor, false, "acceleration: %.2f", GetAcceleration(frameTime));
+	gEnv->pAuxGeomRenderer->Draw2dLabel(50, 60, 2, m_debugColor, false, "Velocity: %.2f", GetVelocity(kinematics).GetLength());
+	gEnv->pAuxGeomRenderer->Draw2dLabel(50, 90, 2, m_debugColor, false, "acceleration: %.2f", GetAcceleration(kinematics, frameTime));
 	gEnv->pAuxGeomRenderer->Draw2dLabel(50, 120, 2, m_debugColor, false, "total impulse: %.3f", GetImpulse());
 
-	DrawDirectionIndicator(frameTime);
+	DrawDirectionIndicator(kinematics, frameTime);
 }
 
 ///////////////////////////////////////////////////////////////////////////
 // FLIGHT MODIFIERS
 ///////////////////////////////////////////////////////////////////////////
 
-void CFlightController::AntiGravity(float frameTime)
+Vec3 CFlightController::GetAntiGravityForce(const SFlightKinematics& kinematics) const
 {
-	gEnv->pAuxGeomRenderer->Draw2dLabel(50, 180, 2, m_debugColor, false, "(G) Anti-Gravity: ON");
+	const Vec3 gravity = gEnv->pPhysicalWorld->GetPhysVars()->gravity;
+	return ToVec3(CFlightModel::GetAntiGravityForce(m_profile, kinematics.motion, ToFlightVec3(gravity)));
+}
 
-	pe_status_dynamics dynamics = GetDynamics();
+void CFlightController::BoostManager(bool isBoosting, float frameTime)
+{
+	m_isBoosting = isBoosting;
 
-	// Get gravity vector
-	Vec3 gravity = gEnv->pPhysicalWorld->GetPhysVars()->gravity;
-	Vec3 antiGravityForce = -gravity * dynamics.mass;
-	float totalAlignment = 0.0f;
-	Vec3 totalScaledAntiGravityForce = Vec3(ZERO);
-	pe_action_impulse impulseAction;
+	if (m_drawFlightDebug)
+		gEnv->pAuxGeomRenderer->Draw2dLabel(50, 150, 2, m_debugColor, false, "(Shift) Boost: %s", isBoosting ? "ON" : "OFF");
+	// Adds a multiplier to the jerk values to enhance the ship's responsiveness, removes the multiplier when not using.
+}
 
-	// First pass: Calculate total alignment
-	for (const auto& axisAccelParamsPair : m_linearParamsMap) // Iterating over each axis within the linear set.
-	{
-		const DynArray<AxisMotionParams>& axisParamsArray = axisAccelParamsPair.second;
+bool CFlightController::FlightModifierHandler(const SFlightKinematics& kinematics, FlightModifierBitFlag& bitFlag, float frameTime)
+{
+	CFlightModel::ResolveModifiers(bitFlag); // Enforcing gravity assist in coupled mode
 
-		for (const auto& accelParams : axisParamsArray)	// Iterate over the DynArray<AxisAccelParams> for the current AxisType
-		{
-			Vec3 localDirection = WorldToLocal(accelParams.localDirection);
+	if (m_drawFlightDebug)
+		gEnv->pAuxGeomRenderer->Draw2dLabel(50, 30, 2, m_debugColor, false, bitFlag.HasFlag(EFlightModifierFlag::Coupled) ? "(V) Coupled" : "(V) Newtonian");
 
-			localDirection.Normalize(); // Normalize to have a range of -1 to 1, which indicates their alignment (1 = perfect / -1 = anti) 
+	// Updates our current requested motion state to compute jerk accordingly
+	CFlightSystem& flightSystem = CFlightSystem::GetInstance();
+	flightSystem.SetTargets(m_flightSlot, CFlightModel::ComputeTargets(m_profile, kinematics.motion, m_shipInput, flightSystem.GetJerkData(m_flightSlot), frameTime));
 
-			float alignment = localDirection.Dot(gravity.GetNormalized()); // Get the alignment between localDirection and gravity, using this to scale the thrust amount
-			if (alignment > ZERO)
-			{
-				totalAlignment += alignment;
-			}
-		}
-	}
+	BoostManager(bitFlag.HasFlag(EFlightModifierFlag::Boost), frameTime);
 
-	// Second pass: Apply impulses proportionally
-	for (const auto& axisAccelParamsPair : m_linearParamsMap)
-	{
-		const DynArray<AxisMotionParams>& axisParamsArray = axisAccelParamsPair.second;
+	// Anti-gravity and debug output are applied in CommitFlightStep, once the flight system has stepped
+	return true;
+}
 
-		for (const auto& accelParams : axisParamsArray)
-		{
-			Vec3 localDirection = WorldToLocal(accelParams.localDirection);
-			localDirection.Normalize();
-
-			float alignment = localDirection.Dot(gravity.GetNormalized());
-			if (alignment > ZERO)
-			{
-				float proportionalAlignment = alignment / totalAlignment;
-				Vec3 scaledAntiGravityForce = antiGravityForce * proportionalAlignment;
-				totalScaledAntiGravityForce += scaledAntiGravityForce;
-				impulseAction.impulse = scaledAntiGravityForce * frameTime;
-				m_pEntity->GetPhysicalEntity()->Action(&impulseAction);
-			}
-		}
-	}
-	m_totalImpulse += totalScaledAntiGravityForce.GetLength();
+///////////////////////////////////////////////////////////////////////////
+// NETWORKING
+///////////////////////////////////////////////////////////////////////////
+bool CFlightController::IsLocallyPiloted() const
+{
+	const CPlayerComponent* pPilot = GetPilot();
+	return pPilot && pPilot->IsLocalClient();
+}
 
+void CFlightController::QueueFlightCommand()
+{
+	m_sentCommands[m_inputSequence % kRedundantCommands].Pack(m_shipInput);
 }
 
-void CFlightController::BoostManager(bool isBoosting, float frameTime)
+void CFlightController::SendFlightCommands(float frameTime)
 {
-	if (isBoosting)
+	// 0 sends a packet every flight step
+	const int sendRate = CFlightSystem::GetInputSendRate();
+	if (sendRate > 0)
 	{
-		m_isBoosting = true;
-		gEnv->pAuxGeomRenderer->Draw2dLabel(50, 150, 2, m_debugColor, false, "(Shift) Boost: ON");
+		m_commandSendTimer -= frameTime;
+		if (m_commandSendTimer > 0.f)
+			return;
+		m_commandSendTimer = std::max(m_commandSendTimer + 1.f / (float)sendRate, 0.f);
 	}
-	else
+
+	// Every command since the last one the server acknowledged, the newest ones if more are outstanding than the history holds
+	SerializeCommandPacket packet;
+	packet.newestSequence = m_inputSequence;
+	const uint32 oldestInHistory = m_inputSequence >= kRedundantCommands ? m_inputSequence - kRedundantCommands + 1 : 1;
+	const uint32 firstSequence = std::max(m_netState.ackSequence + 1, oldestInHistory);
+	for (uint32 sequence = firstSequence; sequence <= m_inputSequence; ++sequence)
 	{
-		m_isBoosting = false;
-		gEnv->pAuxGeomRenderer->Draw2dLabel(50, 150, 2, m_debugColor, false, "(Shift) Boost: OFF");
+		packet.inputs[packet.count++] = m_sentCommands[sequence % kRedundantCommands];
+	}
+
+	if (packet.count > 0)
+	{
+		SRmi<RMI_WRAP(&CFlightController::RequestFlightCommands)>::InvokeOnServer(this, std::move(packet));
 	}
-	// Adds a multiplier to the jerk values to enhance the ship's responsiveness, removes the multiplier when not using.
 }
 
-void CFlightController::FlightModifierHandler(FlightModifierBitFlag bitFlag, float frameTime)
+bool CFlightController::RequestFlightCommands(SerializeCommandPacket&& packet, INetChannel* pChannel)
 {
-	if (bitFlag.HasFlag(EFlightModifierFlag::Coupled))
+	IPhysicalEntity* pPhysicalEntity = GetEntity()->GetPhysics();
+	if (!pPhysicalEntity)
+		return true;
+
+	// Only the seated pilot flies the ship, packets from any other channel are dropped
+	const CPlayerComponent* pPilot = m_pVehicleComponent->GetIsPiloting() ? GetPilot() : nullptr;
+	if (!pPilot || pPilot->GetEntity()->GetNetEntity()->GetChannelId() != gEnv->pGameFramework->GetGameChannelId(pChannel))
+		return true;
+
+	// Packets arrive unordered and repeat their commands, the queue keeps each sequence once. Nothing is applied here, only by the flight steps.
+	for (uint8 i = 0; i < packet.count; ++i)
 	{
-		CoupledFM(frameTime);
-		bitFlag.SetFlag(EFlightModifierFlag::Gravity); // Enforcing gravity assist in coupled mode
+		m_remoteInputs.Push(pChannel, packet.GetSequence(i), packet.inputs[i]);
 	}
-	else
+	return true;
+}
+
+void CFlightController::GetNetState(SShipNetState& state, bool isOwnShip)
+{
+	const pe_status_dynamics dynamics = GetDynamics();
+
+	// The state right now, with the last pilot input it includes
+	state.position = m_pEntity->GetWorldPos();
+	state.orientation = m_pEntity->GetWorldRotation();
+	state.velocity = dynamics.v;
+	state.angularVelocity = dynamics.w;
+	state.serverTime = CFlightSystem::GetInstance().GetLevelTime();
+
+	state.isOwnShip = isOwnShip;
+	state.ackSequence = isOwnShip ? m_inputSequence : 0;
+	if (isOwnShip && m_flightSlot != CFlightSystem::kInvalidSlot)
 	{
-		DirectInput(frameTime);
+		const CFlightSystem& flightSystem = CFlightSystem::GetInstance();
+		for (size_t group = 0; group < (size_t)CFlightSystem::EJerkGroup::Count; ++group)
+		{
+			state.currentAccel[group] = flightSystem.GetCurrentAccel(m_flightSlot, (EJerkGroup)group);
+		}
 	}
-	if (bitFlag.HasFlag(EFlightModifierFlag::Boost))
+}
+
+void CFlightController::OnServerState(const SShipNetState& state)
+{
+	// Snapshots are unordered, an older state than the one we have is of no use
+	if (gEnv->bServer || state.serverTime <= m_netState.serverTime)
+		return;
+
+	m_netState = state;
+
+	// The pilot reconciles on its next flight step, everyone else plays the states back with a delay
+	if (IsLocallyPiloted())
 	{
-		BoostManager(true, frameTime);
+		// The jerk state and acknowledgement only come with the pilot's own snapshot (not yet when just seated)
+		m_hasServerState = state.isOwnShip;
 	}
 	else
 	{
-		BoostManager(false, frameTime);
+		SShipSnapshot snapshot;
+		snapshot.time = m_netState.serverTime;
+		snapshot.position = m_netState.position;
+		snapshot.orientation = m_netState.orientation;
+		snapshot.velocity = m_netState.velocity;
+		snapshot.angularVelocity = m_netState.angularVelocity;
+		m_snapshots.Push(snapshot);
 	}
-	if (bitFlag.HasFlag(EFlightModifierFlag::Gravity))
+}
+
+void CFlightController::UpdateSnapshotPlayback(float frameTime)
+{
+	if (m_snapshots.IsEmpty())
+		return;
+
+	// Our own ship now, prediction takes over
+	if (gEnv->bServer || IsLocallyPiloted())
 	{
-		AntiGravity(frameTime);
+		m_snapshots.Clear();
+		return;
 	}
-	else
-		gEnv->pAuxGeomRenderer->Draw2dLabel(50, 180, 2, m_debugColor, false, "(G) Anti-Gravity: OFF");
 
-	// Debug stuff - Includes 2d velocity vector display
-	DrawOnScreenDebugText(frameTime);
+	SShipSnapshot state;
+	if (m_snapshots.Sample(frameTime, CFlightSystem::GetInterpolationDelay(), CFlightSystem::GetMaxExtrapolation(), state))
+	{
+		ApplyPhysicsState(state.position, state.orientation, state.velocity, state.angularVelocity);
+	}
 }
 
 ///////////////////////////////////////////////////////////////////////////
-// NETWORKING
+// CLIENT PREDICTION
 ///////////////////////////////////////////////////////////////////////////
-bool CFlightController::RequestImpulseOnServer(SerializeImpulseData&& data, INetChannel*)
+void CFlightController::StorePredictionResult()
 {
-	IPhysicalEntity* pPhysicalEntity = GetEntity()->GetPhysics();
+	SPredictedStep& step = m_predictedSteps[m_inputSequence % kPredictionBufferSize];
+	if (m_inputSequence == 0 || step.sequence != m_inputSequence || step.hasResult)
+		return;
 
-	if (pPhysicalEntity)
-	{
-		MotionData motionData(data.linearImpulse, data.rollImpulse,
-			data.pitchYawImpulse, &m_linearJerkData, &m_rollJerkData, &m_pitchYawJerkData);
-		AccelToImpulse(motionData, m_frameTime);
-		SRmi<RMI_WRAP(&CFlightController::UpdateMovement)>::InvokeOnAllClients(this, std::move(data));
+	step.position = m_pEntity->GetWorldPos();
+	step.orientation = m_kinematics.orientation;
+	step.velocity = m_kinematics.velocity;
+	step.angularVelocity = m_kinematics.angularVelocity;
+	step.hasResult = true;
+}
 
-		// Update position and orientation serialization variables
-		m_shipPosition = GetEntity()->GetWorldPos();
-		Matrix34 shipWorldTM = GetEntity()->GetWorldTM();
-		m_shipOrientation = Quat(shipWorldTM);
-		m_shipPosition = shipWorldTM.GetTranslation();
-	}
-	return true;
+void CFlightController::RecordPrediction(float frameTime)
+{
+	const CFlightSystem& flightSystem = CFlightSystem::GetInstance();
+
+	SPredictedStep& step = m_predictedSteps[m_inputSequence % kPredictionBufferSize];
+	step.sequence = m_inputSequence;
+	step.frameTime = frameTime;
+	step.jerk = flightSystem.GetJerkData(m_flightSlot);
+	step.mass = m_kinematics.mass;
+	step.linearScale = CFlightModel::GetLinearScale(m_profile, m_activeModifiers);
+	step.angularScale = CFlightModel::GetAngularScale(m_profile, m_activeModifiers);
+	step.applyFlightImpulse = m_applyFlightImpulse;
+	// The same force CommitFlightModifiers applies this step
+	step.antiGravityImpulse = m_activeModifiers.HasFlag(EFlightModifierFlag::Gravity) ? GetAntiGravityForce(m_kinematics) * frameTime : Vec3(ZERO);
+	step.hasResult = false;
 }
 
-bool CFlightController::UpdateMovement(SerializeImpulseData&& data, INetChannel*)
+bool CFlightController::Reconcile()
 {
-	IPhysicalEntity* pPhysicalEntity = GetEntity()->GetPhysics();
-	if (pPhysicalEntity)
+	if (!m_hasServerState)
+		return false;
+	m_hasServerState = false;
+
+	const SShipNetState& server = m_netState;
+	const SPredictedStep& acked = m_predictedSteps[server.ackSequence % kPredictionBufferSize];
+
+	// Nothing to compare with: no input acknowledged yet, or the server is too far behind for the buffer
+	if (server.ackSequence == 0 || server.ackSequence > m_inputSequence || m_inputSequence - server.ackSequence >= kPredictionBufferSize)
+		return false;
+	if (acked.sequence != server.ackSequence || !acked.hasResult)
+		return false;
+
+	// Prediction still matches the server
+	if (acked.position.GetDistance(server.position) <= m_reconcileThreshold && acked.velocity.GetDistance(server.velocity) <= m_reconcileThreshold)
+		return false;
+
+	// Angular motion goes through the inertia tensor owned by physics, the rotation predicted since the acked step is kept and moved onto the server state
+	const Quat orientationCorrection = server.orientation * acked.orientation.GetInverted();
+	const Vec3 angularVelocityCorrection = server.angularVelocity - acked.angularVelocity;
+
+	// Linear motion and jerk are rewound to the server state, and every input it has not seen yet is replayed
+	const Vec3 gravity = gEnv->pPhysicalWorld->GetPhysVars()->gravity;
+	std::array<SFlightVec3, (size_t)EJerkGroup::Count> currentAccel;
+	for (size_t group = 0; group < (size_t)EJerkGroup::Count; ++group)
 	{
-		NetMarkAspectsDirty(kVehicleAspect);
+		currentAccel[group] = ToFlightVec3(server.currentAccel[group]);
 	}
+	Vec3 position = server.position;
+	Vec3 velocity = server.velocity;
+	Quat orientation = server.orientation;
+	Vec3 angularVelocity = server.angularVelocity;
+
+	for (uint32 sequence = server.ackSequence + 1; sequence <= m_inputSequence; ++sequence)
+	{
+		SPredictedStep& step = m_predictedSteps[sequence % kPredictionBufferSize];
+		if (step.sequence != sequence || !step.hasResult)
+			return false;
+
+		for (size_t group = 0; group < (size_t)EJerkGroup::Count; ++group)
+		{
+			JerkAccelerationData jerk = step.jerk[group];
+			jerk.currentJerkAccel = currentAccel[group];
+			CFlightModel::StepJerk(jerk, step.frameTime);
+			currentAccel[group] = jerk.currentJerkAccel;
+		}
+
+		orientation = (orientationCorrection * step.orientation).GetNormalized();
+
+		// Same conversion and impulse path as the step itself, the angular share only matters for what the thrusters can deliver
+		Vec3 linearImpulse = ZERO, angularImpulse = ZERO;
+		if (step.applyFlightImpulse && step.mass > 0.f)
+		{
+			const SFlightVec3 angularAccel = currentAccel[(size_t)EJerkGroup::Roll] + currentAccel[(size_t)EJerkGroup::PitchYaw];
+			ResolveImpulse(ToVec3(CFlightModel::AccelToImpulse(currentAccel[(size_t)EJerkGroup::Linear], step.mass, step.linearScale, step.frameTime)),
+				ToVec3(CFlightModel::AccelToImpulse(angularAccel, step.mass, step.angularScale, step.frameTime)),
+				orientation, step.frameTime, linearImpulse, angularImpulse);
+		}
+
+		if (step.mass > 0.f)
+			velocity += (linearImpulse + step.antiGravityImpulse) / step.mass;
+		velocity += gravity * step.frameTime;
+		position += velocity * step.frameTime;
+
+		angularVelocity = step.angularVelocity + angularVelocityCorrection;
+
+		// Corrected in place, later acknowledgements compare against the replayed state
+		step.position = position;
+		step.velocity = velocity;
+		step.orientation = orientation;
+		step.angularVelocity = angularVelocity;
+	}
+
+	ApplyPhysicsState(position, orientation, velocity, angularVelocity);
+
+	CFlightSystem& flightSystem = CFlightSystem::GetInstance();
+	for (size_t group = 0; group < (size_t)EJerkGroup::Count; ++group)
+	{
+		flightSystem.SetCurrentAccel(m_flightSlot, (EJerkGroup)group, ToVec3(currentAccel[group]));
+	}
+
+	// The velocity action may still be queued in physics, the step continues from the corrected state
+	UpdateKinematics();
+	m_kinematics.velocity = velocity;
+	m_kinematics.angularVelocity = angularVelocity;
+	m_kinematics.localVelocity = m_kinematics.orientation.GetInverted() * velocity;
+	m_kinematics.motion.velocity = ToFlightVec3(velocity);
+	m_kinematics.motion.angularVelocity = ToFlightVec3(angularVelocity);
 	return true;
 }
 
-bool CFlightController::NetSerialize(TSerialize ser, EEntityAspects aspect, uint8 profile, int flags)
+void CFlightController::ApplyPhysicsState(const Vec3& position, const Quat& orientation, const Vec3& velocity, const Vec3& angularVelocity)
 {
-	if (aspect & kVehicleAspect)
-	{
-		ser.BeginGroup("vehicleMovement");
-
-		ser.Value("m_shipPosition", m_shipPosition, 'wrld');
-		ser.Value("m_shipOrientation", m_shipOrientation, 'ori3');
-		ser.EndGroup();
+	m_pEntity->SetPosRotScale(position, orientation, m_pEntity->GetScale());
 
-		return true;
+	if (IPhysicalEntity* pPhysicalEntity = m_pEntity->GetPhysicalEntity())
+	{
+		pe_action_set_velocity setVelocity;
+		setVelocity.v = velocity;
+		setVelocity.w = angularVelocity;
+		pPhysicalEntity->Action(&setVelocity);
 	}
-	return false;
-}
\ No newline at end of file
+}
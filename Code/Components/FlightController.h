@@ -4,65 +4,93 @@
 #include <numeric>
 
 #include <Components/FlightModifiers.h>
+#include <Components/FlightSystem.h>
+#include <Components/RemoteInputQueue.h>
+#include <Components/ShipInput.h>
+#include <Components/ShipSnapshotBuffer.h>
+#include <Components/ThrusterAllocator.h>
 #include <CryPhysics/physinterface.h>
 
 class CVehicleComponent;
+class CPlayerComponent;
+class CShipThrusterComponent;
 
 namespace Cry::DefaultComponents
 {
 	class CRigidBodyComponent;
 }
 
-class ScaledMotion
+// Impulses gathered from every contributor of a ship during a step, sent to physics as a single action
+struct SShipWrench
 {
-public:
-	ScaledMotion(const Vec3& scaledAccel, const Vec3& scaledVel)
-		: m_scaledAccel(scaledAccel), m_scaledVel(scaledVel) {}
+	Vec3 linearImpulse = ZERO;
+	Vec3 angularImpulse = ZERO;
 
-	Vec3 GetAcceleration() const { return m_scaledAccel; }
-	Vec3 GetVelocity() const { return m_scaledVel; }
+	void Add(const Vec3& linear, const Vec3& angular)
+	{
+		linearImpulse += linear;
+		angularImpulse += angular;
+	}
 
-private:
-	Vec3 m_scaledAccel; // Scaled acceleration direction vector
-	Vec3 m_scaledVel;   // Scaled velocity direction vector
+	bool IsZero() const { return linearImpulse.IsZero() && angularImpulse.IsZero(); }
+	void Clear() { linearImpulse = ZERO; angularImpulse = ZERO; }
 };
 
-class VelocityDiscrepancy
+// Kinematic state of the ship, fetched once per flight step and shared read-only by every flight stage
+struct SFlightKinematics
 {
-public:
-	VelocityDiscrepancy(const Vec3& linearDiscrepancy, const Vec3& angularDiscrepancy)
-		: m_linearDiscrepancy(linearDiscrepancy), m_angularDiscrepancy(angularDiscrepancy) {}
-
-	Vec3 GetLinearDiscrepancy() const { return m_linearDiscrepancy; }
-	Vec3 GetAngularDiscrepancy() const { return m_angularDiscrepancy; }
-
-private:
-	Vec3 m_linearDiscrepancy; // Scaled acceleration direction vector
-	Vec3 m_angularDiscrepancy;   // Scaled velocity direction vector
+	Vec3 velocity = ZERO;        // World space linear velocity
+	Vec3 angularVelocity = ZERO; // World space angular velocity
+	Vec3 localVelocity = ZERO;   // Linear velocity in ship space
+	float mass = 0.f;
+	Quat orientation = IDENTITY;
+
+	// The same state for the flight model, with the world space thrust direction of every axis rotated once per step
+	SFlightMotion motion;
 };
 
-class ImpulseResult
+// Authoritative state of a ship, packed by the server into the snapshot of each client it is relevant to (CShipReplication).
+// The pilot's client reconciles against it, other clients play it back through their snapshot buffer.
+struct SShipNetState
 {
-public:
-
-	ImpulseResult() : m_linearImpulse(Vec3(ZERO)), m_angularImpulse(Vec3(ZERO)) {}
-	ImpulseResult(const Vec3& lin, const Vec3& ang) : m_linearImpulse(lin), m_angularImpulse(ang) {}
+	Vec3 position = ZERO;
+	Quat orientation = IDENTITY;
+	Vec3 velocity = ZERO;
+	Vec3 angularVelocity = ZERO;
+	float serverTime = 0.f; // Server level time the state was taken at (CFlightSystem::GetLevelTime), sent once per snapshot
+
+	// Only sent to the pilot of the ship, for the reconciliation. Other clients play the ship back from the pose and velocities.
+	bool isOwnShip = false;
+	std::array<Vec3, (size_t)CFlightSystem::EJerkGroup::Count> currentAccel = {}; // Jerk-smoothed acceleration of every group
+	uint32 ackSequence = 0; // Last pilot input applied by the server, 0 if none
+
+	// Uncompressed size of the serialized fields, an upper bound of what the compression policies put on the wire
+	static constexpr int kSharedBytes = (int)(sizeof(Vec3) * 3 + sizeof(Quat) + sizeof(bool));
+	static constexpr int kOwnShipBytes = (int)(sizeof(Vec3) * (size_t)CFlightSystem::EJerkGroup::Count + sizeof(uint32));
+
+	void SerializeWith(TSerialize ser)
+	{
+		ser.Value("position", position, 'wrld');
+		ser.Value("orientation", orientation, 'ori3');
+		ser.Value("velocity", velocity);
+		ser.Value("angularVelocity", angularVelocity);
 
-	Vec3 GetLinearImpulse() const { return m_linearImpulse; };
-	Vec3 GetAngularImpulse() const { return m_angularImpulse; };
-private:
-	Vec3 m_linearImpulse;
-	Vec3 m_angularImpulse;
+		ser.Value("isOwnShip", isOwnShip);
+		if (isOwnShip)
+		{
+			ser.Value("linearAccel", currentAccel[(size_t)CFlightSystem::EJerkGroup::Linear]);
+			ser.Value("rollAccel", currentAccel[(size_t)CFlightSystem::EJerkGroup::Roll]);
+			ser.Value("pitchYawAccel", currentAccel[(size_t)CFlightSystem::EJerkGroup::PitchYaw]);
+			ser.Value("ackSequence", ackSequence);
+		}
+	}
 };
 
-
 class CFlightController final : public IEntityComponent
 {
-	static constexpr EEntityAspects kVehicleAspect = eEA_GameClientA;
-
 public:
 	CFlightController() = default;
-	virtual ~CFlightController() = default;
+	virtual ~CFlightController();
 
 	virtual void Initialize() override;
 
@@ -70,11 +98,6 @@ public:
 
 	virtual void ProcessEvent(const SEntityEvent& event) override;
 
-
-	virtual bool NetSerialize(TSerialize ser, EEntityAspects aspect, uint8 profile, int flags) override;
-
-	virtual NetworkAspectType GetNetSerializeAspectMask() const override { return kVehicleAspect; }
-
 	// Reflect type to set a unique identifier for this component
 	// and provide additional information to expose it in the sandbox
 	static void ReflectType(Schematyc::CTypeDesc<CFlightController>& desc)
@@ -122,87 +145,129 @@ public:
 		// Coupled mode log scaling for velocity
 		desc.AddMember(&CFlightController::m_linearLogBase, 'llb', "linearlogbase", "(Coupled) linear log base", "More aggressive scaling for smaller values < 1", ZERO);
 		desc.AddMember(&CFlightController::m_linearLogMaxDiscrepancy, 'llmd', "linearlogmaxdisc", "(Coupled) linear log max disc", "Adjusts the maximum discrepancy taken into account", ZERO);
+		desc.AddMember(&CFlightController::m_correctionLookahead, 'clah', "correctionlookahead", "(Coupled) correction lookahead", "Seconds ahead the overshoot is predicted, 0 uses the frame time", ZERO);
+
+		// Client prediction
+		desc.AddMember(&CFlightController::m_reconcileThreshold, 'rcth', "reconcilethreshold", "Reconcile threshold", "Position (m) or velocity (m/s) error above which the pilot's client replays its inputs from the server state", 0.25f);
 	}
 
-	// Axis Vector initializer
+	// Builds the flight profile from the editor values
 	void InitializeMotionParamsVectors();
 	// Jerk data initializer
 	void InitializeJerkParams();
 	// Reset the jerk values 
 	void ResetJerkParams();
 
+	// Called by CFlightSystem before the batched step, publishes this ship's target accelerations. Returns true if the impulse should be applied locally.
+	bool PrepareFlightStep(float frameTime);
+	// Called by CFlightSystem after the batched step with the impulses computed for this ship
+	void CommitFlightStep(const Vec3& linearImpulse, const Vec3& angularImpulse, float frameTime);
+
+	// Anti-gravity and debug output of the step, also used on its own when the impulses are applied by the physics step
+	void CommitFlightModifiers(float frameTime);
+
+	// Thruster components of this ship. With at least one registered, the flight impulse is allocated to the thrusters
+	void RegisterThruster(CShipThrusterComponent* pThruster);
+	void UnregisterThruster(CShipThrusterComponent* pThruster);
+	void OnThrusterLayoutChanged();
+
+	// Every impulse on the ship goes through the wrench (flight mode, anti-gravity, boost, thrusters)
+	void AddImpulse(const Vec3& linearImpulse, const Vec3& angularImpulse);
+	// Sends the accumulated wrench to physics as one action, and counts it in the impulse telemetry
+	void CommitWrench();
+	bool IsApplyingFlightImpulse() const { return m_applyFlightImpulse; }
+
+	// Physics step mode: asks the physical entity for post step events
+	void SetPostStepMonitoring(bool enable);
+
+	// Fixed timestep only: stores the pose physics reached after the last flight ticks, and renders the ship between the last two
+	void RecordFlightPose();
+	void UpdatePresentation(float alpha);
+	void ResetPresentation();
+
+	// Remote ships on clients: moves the ship along its buffered snapshots, once per frame
+	void UpdateSnapshotPlayback(float frameTime);
+	// Not simulated here: placed by UpdateSnapshotPlayback, outside of the flight ticks
+	bool IsPlayingSnapshots() const { return !m_snapshots.IsEmpty(); }
+
+	// Server: the current state of the ship, gathered into the client snapshots by CShipReplication.
+	// The reconciliation state is only filled for the pilot's own snapshot.
+	void GetNetState(SShipNetState& state, bool isOwnShip);
+	// Client: a state of this ship received in a snapshot
+	void OnServerState(const SShipNetState& state);
+
 	// Physical Entity reference
 	IPhysicalEntity* physEntity = nullptr;
 
-	enum class EAccelState
-	{
-		Accelerating,
-		Decelerating
-	};
-
 protected:
 private:
 
-	struct SerializeImpulseData
+	// Raw pilot input, the server rebuilds the accelerations from its own ship profile
+	static void SerializeInput(TSerialize ser, SQuantizedShipInput& input)
 	{
-		Vec3 position = ZERO;        // Position of the entity
-		Quat orientation = ZERO;     // Orientation of the entity
-		Vec3 linearImpulse = ZERO;   // Linear impulse to be applied
-		Vec3 rollImpulse = ZERO;  // Angular impulse to be applied
-		Vec3 pitchYawImpulse = ZERO;  // Angular impulse to be applied
+		// One name per axis, in EShipAxis order
+		static const char* const byteAxisNames[SQuantizedShipInput::kByteAxisCount] = { "accelForward", "accelBackward", "accelLeft", "accelRight", "accelUp", "accelDown", "rollLeft", "rollRight" };
+		static const char* const aimAxisNames[SQuantizedShipInput::kAimAxisCount] = { "yaw", "pitch" };
+
+		for (size_t i = 0; i < SQuantizedShipInput::kByteAxisCount; ++i)
+			ser.Value(byteAxisNames[i], input.byteAxes[i]);
+		for (size_t i = 0; i < SQuantizedShipInput::kAimAxisCount; ++i)
+			ser.Value(aimAxisNames[i], input.aimAxes[i]);
+		ser.Value("modifiers", input.modifiers);
+	}
 
-		void SerializeWith(TSerialize ser)
-		{
-			ser.Value("position", position, 'wrld');
-			ser.Value("orientation", orientation, 'ori3');
-			ser.Value("linearImpulse", linearImpulse);
-			ser.Value("angularImpulse", rollImpulse);
-			ser.Value("angularImpulse", pitchYawImpulse);
-		}
-	};
+	// Commands not acknowledged by the server are repeated in every input packet, up to what its queue can hold.
+	// A lost packet is covered by the next ones however long the round trip.
+	static constexpr uint8 kRedundantCommands = (uint8)CRemoteInputQueue::kCapacity;
 
-	struct SerializeImpulse
+	// The unacknowledged inputs of the pilot, oldest first. Sequences are consecutive, only the newest is sent.
+	// Sent unreliable, the server drops the sequences it already has.
+	struct SerializeCommandPacket
 	{
-		Vec3 impulse = ZERO;
+		uint32 newestSequence = 0;
+		uint8 count = 0;
+		std::array<SQuantizedShipInput, kRedundantCommands> inputs;
 
-		void SerializeWith(TSerialize ser)
-		{
-			ser.Value("impulse", impulse);
-		}
-	};
-
-	struct SerializeTransformData
-	{
-		Vec3 position;
-		Quat orientation;
+		uint32 GetSequence(uint8 index) const { return newestSequence - (count - 1 - index); }
 
 		void SerializeWith(TSerialize ser)
 		{
-			ser.Value("position", position, 'wrld');
-			ser.Value("orientation", orientation, 'ori3');
+			ser.Value("newestSequence", newestSequence);
+			ser.Value("count", count);
+			if (count > kRedundantCommands)
+				count = kRedundantCommands;
+			for (uint8 i = 0; i < count; ++i)
+			{
+				SerializeInput(ser, inputs[i]);
+			}
 		}
 	};
 
-	enum class AxisType
+	// A step predicted by the pilot's client, kept until the server has acknowledged its input
+	struct SPredictedStep
 	{
-		Roll,
-		PitchYaw,
-		Linear
-	};
-
-	// struct to combine thruster axis and actuation
-	struct AxisMotionParams {
-		string axisName;
-		float AccelAmount;
-		float velocityLimit;
-		Vec3 localDirection;
+		uint32 sequence = 0;
+		float frameTime = 0.f;
+		std::array<JerkAccelerationData, (size_t)CFlightSystem::EJerkGroup::Count> jerk; // Jerk state with the targets of the step, before it ran
+		float mass = 0.f;
+		float linearScale = 1.f;
+		float angularScale = 1.f;
+		bool applyFlightImpulse = false;
+		Vec3 antiGravityImpulse = ZERO;
+
+		// Resulting state, filled by the next step
+		bool hasResult = false;
+		Vec3 position = ZERO;
+		Quat orientation = IDENTITY;
+		Vec3 velocity = ZERO;
+		Vec3 angularVelocity = ZERO;
 	};
 
-	// Vector maps to organize our axis types, names and input data together 
-	VectorMap<AxisType, DynArray<AxisMotionParams>> m_linearParamsMap;
-	VectorMap<AxisType, DynArray<AxisMotionParams>> m_rollParamsMap;
-	VectorMap<AxisType, DynArray<AxisMotionParams>> m_pitchYawParamsMap;
+	// Steps of input the client can run ahead of the server, about 2 seconds at 60 fps
+	static constexpr uint32 kPredictionBufferSize = 128;
 
+	// Performance of the ship in flight model form, built from the editor values
+	SFlightProfile m_profile;
 
 	struct VelocityData
 	{
@@ -214,116 +279,75 @@ private:
 
 	VelocityData m_shipVelocity = {};
 
-	// Accel data structures. Jerk values for each are set in Initialize(), retrieved from the editor settings.
-	struct JerkAccelerationData
-	{
-		float jerk;
-		float jerkDecelRate;
-		Vec3 currentJerkAccel;
-		Vec3 targetJerkAccel;
-		EAccelState state;
-
-		JerkAccelerationData() : jerk(0.f), jerkDecelRate(0.f), currentJerkAccel(0.f), targetJerkAccel(0.f), state(EAccelState::Decelerating) {}
-	};
-
-	JerkAccelerationData m_linearJerkData = {};
-	JerkAccelerationData m_rollJerkData = {};
-	JerkAccelerationData m_pitchYawJerkData = {};
-
-	struct MotionData {
-		Vec3 linearAccel;
-		Vec3 rollAccel;
-		Vec3 pitchYawAccel;
-		JerkAccelerationData* linearJerkData;
-		JerkAccelerationData* rollJerkData;
-		JerkAccelerationData* pitchYawJerkData;
-
-		// Default constructor
-		MotionData()
-			: linearAccel(Vec3(ZERO)), rollAccel(Vec3(ZERO)), pitchYawAccel(Vec3(ZERO)),
-			linearJerkData(nullptr), rollJerkData(nullptr), pitchYawJerkData(nullptr) {}
-
-		// Parameterized constructor
-		MotionData(Vec3 linear, Vec3 roll, Vec3 pitchYaw, JerkAccelerationData* linearJerk, JerkAccelerationData* rollJerk, JerkAccelerationData* pitchYawJerk)
-			: linearAccel(linear), rollAccel(roll), pitchYawAccel(pitchYaw),
-			linearJerkData(linearJerk), rollJerkData(rollJerk), pitchYawJerkData(pitchYawJerk) {}
-	};
+	// Slot holding this ship's jerk state in the flight system. Jerk values for each group are set in InitializeJerkParams(), retrieved from the editor settings.
+	CFlightSystem::SlotId m_flightSlot = CFlightSystem::kInvalidSlot;
 
 	// Getting the dynamics 
 	pe_status_dynamics GetDynamics();
 
-	// Getting the key states from the Vehicle
-	FlightModifierBitFlag GetFlightModifierState();
-
-	// Getting the Axis values from the Vehicle
-	float AxisGetter(const string& axisName);
-
-	// Convert world coordinates to local coordinates
-	Vec3 WorldToLocal(const Vec3& localDirection);
-
-	// Clamping the input between -1 and 1, as well as implementing mouse sensitivity scale for the newtonian mode.
-	float ClampInput(float inputValue, float maxAxisAccel, bool mouseScaling = false) const;
-
-	/* This function is instrumental for the correct execution of UpdateAccelerationWithJerk()
-	*  This function is called by each axis group independently (Pitch / Yaw; Roll; Linear)
-	*  Obtains the target acceleration from the JerkAccelerationData struct and updates the struct with the current state.
-	*  targetAccel is upated according to the player input (-1; 1). Any value different than zero means the player wants to move.
-	*  Simply sets the acceleration state if the target Accel is zero.
-	*/
-	void UpdateAccelerationState(JerkAccelerationData& accelData, const Vec3& targetAccel);
-
-	// Compares the current vs target accel, and calculates the jerk
-	Vec3 UpdateAccelerationWithJerk(AxisType axisType, JerkAccelerationData& accelData, float frameTime) const;
+	// Queries the physics and the entity transform once, and rotates the thruster basis
+	void UpdateKinematics();
 
-	// Scales the acceleration asked, according to input magnitude, taking into account the inputs pressed
-	ScaledMotion ScaleInput(const VectorMap<AxisType, DynArray<AxisMotionParams>>& axisAccelParamsMap);
+	// Feeds the flight recorder, with the ship's profile and starting state on the first recorded step
+	void RecordFlightInput(float frameTime);
 
-	VelocityDiscrepancy CalculateDiscrepancy(Vec3 desiredLinearVelocity);
-	// Compute logarithmic scaling in the corrective calculation (Coupled mode) to provide a smoother flying experience.
-	float LogScale(float discrepancyMagnitude, float maxDiscrepancy, float base);
+	// Getting the key states from the pilot's input snapshot
+	FlightModifierBitFlag GetFlightModifierState() const;
 
-	Vec3 CalculateCorrection(const VectorMap<AxisType, DynArray<AxisMotionParams>>& axisAccelParamsMap, Vec3 requestedVelocity, Vec3 linearDiscrepancy);
+	// The pilot sitting in this ship, if any
+	CPlayerComponent* GetPilot() const;
 
-	/* Direct input mode: raw acceleration requests on an input scale
-	*  Step 1. For each axis group, call ScaleAccel to create a scaled direction vector by input in local space
-	*  Step 2. Jerk gets infused
-	*  Step 3. Directly convert the result of step 2 into a force and apply it
-	*/
-	void DirectInput(float frameTime);
+	// Getting the Axis values from the pilot's input snapshot
+	float AxisGetter(EShipAxis axis) const;
 
-	void CoupledFM(float frameTime);
+	// Clamping the input between -1 and 1, as well as implementing mouse sensitivity scale for the newtonian mode.
+	float ClampInput(float inputValue, float maxAxisAccel, bool mouseScaling = false) const;
 
-	// Compensates for the gravity pull
-	void AntiGravity(float frameTime);
+	// Force compensating the gravity pull, spread over the thrusters facing it
+	Vec3 GetAntiGravityForce(const SFlightKinematics& kinematics) const;
 
 	void BoostManager(bool isBoosting, float frameTime);
 
-	// toggle between the flight modes on a key press
-	void FlightModifierHandler(FlightModifierBitFlag bitFlag, float frameTime);
+	/* Toggles between the flight modes on a key press, and publishes the target accelerations of the mode to the flight system.
+	*  Newtonian: the input scaled to accelerations. Coupled: corrections towards the input scaled to velocities, accounting for overshoot.
+	*  Returns true if the resulting request should be applied locally
+	*/
+	bool FlightModifierHandler(const SFlightKinematics& kinematics, FlightModifierBitFlag& bitFlag, float frameTime);
 
-	// Converts the accel target (after jerk) which contains both direction and magnitude, into thrust values.
-	ImpulseResult AccelToImpulse(const MotionData& motionData, float frameTime, bool mathOnly = false);
 	float GetImpulse() const;
 	void ResetImpulseCounter();
 
-	// Applies an impulse, with optional parameters. roll and pitch / yaw (angular axes) will be combined.
-	void ApplyImpulse(Vec3 linearImpulse, Vec3 angImpulse, bool mathOnly = false);
+	// Adds the impulse computed by the flight system to the wrench. roll and pitch / yaw (angular axes) are already combined.
+	void ApplyImpulse(const Vec3& linearImpulse, const Vec3& angImpulse);
+	// What the ship actually receives for a flight impulse: the thrusters' achievable share when they have authority, else the impulse itself
+	void ResolveImpulse(const Vec3& linearImpulse, const Vec3& angImpulse, const Quat& orientation, float frameTime, Vec3& outLinear, Vec3& outAngular);
 
 	// Calculate current vel / accel
-	Vec3 GetVelocity();
-	float GetAcceleration(float frameTime);
+	Vec3 GetVelocity(const SFlightKinematics& kinematics) const;
+	float GetAcceleration(const SFlightKinematics& kinematics, float frameTime);
 
 	// TVI
 
-	void DrawDirectionIndicator(float frameTime);
+	void DrawDirectionIndicator(const SFlightKinematics& kinematics, float frameTime);
 
 	// Debug
-	void DrawOnScreenDebugText(float frameTime);
+	void DrawOnScreenDebugText(const SFlightKinematics& kinematics, float frameTime);
 
 	// Networking
-	bool RequestImpulseOnServer(SerializeImpulseData&& data, INetChannel*);
+	bool IsLocallyPiloted() const;
+	// Clamps every axis to [-1, 1] (mouse sensitivity included) and rounds it to its network precision, so the client predicts with the input the server gets
+	void NormalizeInput(SShipInputSnapshot& input) const;
+	// Stores the input of the step, SendFlightCommands sends the recent ones at flight_inputSendRate
+	void QueueFlightCommand();
+	void SendFlightCommands(float frameTime);
+
+	// Client prediction: the result of the previous step is stored, and the predicted steps are replayed when the server disagrees
+	void StorePredictionResult();
+	void RecordPrediction(float frameTime);
+	bool Reconcile();
+	void ApplyPhysicsState(const Vec3& position, const Quat& orientation, const Vec3& velocity, const Vec3& angularVelocity);
 
-	bool UpdateMovement(SerializeImpulseData&& data, INetChannel*);
+	bool RequestFlightCommands(SerializeCommandPacket&& packet, INetChannel*);
 
 	// Components
 	CVehicleComponent* m_pVehicleComponent = nullptr;
@@ -369,23 +393,73 @@ private:
 	float m_PitchYawJerkDecelRate = 0.f;
 	float m_linearLogBase = 0.f;
 	float m_linearLogMaxDiscrepancy = 0.f;
+	float m_correctionLookahead = 0.f;
+	float m_reconcileThreshold = 0.25f;
 
 	// Tracking the impulses generated
 	float m_totalImpulse = 0.f;
-	float m_totalAngularImpulse = 0.f;
+	SShipWrench m_wrench;
+
+	// Control allocation over the thruster components
+	CThrusterAllocator m_thrusterAllocator;
 	Vec3 m_linearImpulse = ZERO;
 	Vec3 m_angularImpulse = ZERO;
 
 	// Tracking boost state
 	bool m_isBoosting = false;
 
+	// Pilot input copied once per flight step
+	SShipInputSnapshot m_shipInput;
+
+	// Kinematic context of the current flight step
+	SFlightKinematics m_kinematics;
+
+	// Poses of the last two fixed flight ticks, used to interpolate the rendered geometry
+	QuatT m_previousFlightPose = QuatT(IDENTITY);
+	QuatT m_currentFlightPose = QuatT(IDENTITY);
+	bool m_hasFlightPose = false;
+	bool m_hasPresentationOffset = false;
+
+	// Mesh slots offset to the interpolated pose, with their own local transform
+	struct SPresentedSlot
+	{
+		int slot;
+		Matrix34 localTM;
+	};
+	std::vector<SPresentedSlot> m_presentedSlots;
+
+	bool m_monitorsPostStep = false;
+
+	// Modifiers resolved during PrepareFlightStep, consumed by CommitFlightStep
+	FlightModifierBitFlag m_activeModifiers;
+	bool m_applyFlightImpulse = false;
+	bool m_applyModifiers = false;
+	bool m_drawFlightDebug = false;
+
+	// Server: inputs received from the remote pilot's channel, one is consumed per flight step
+	CRemoteInputQueue m_remoteInputs;
+	SQuantizedShipInput m_remoteInput;
+
+	// Client: the last inputs, indexed by sequence, and the time left until the next packet. The server's acknowledgement is m_netState.ackSequence.
+	std::array<SQuantizedShipInput, kRedundantCommands> m_sentCommands;
+	float m_commandSendTimer = 0.f;
+
+	// Server: last input applied, client: last input sent
+	uint32 m_inputSequence = 0;
+
+	// Client prediction, indexed by input sequence
+	std::array<SPredictedStep, kPredictionBufferSize> m_predictedSteps;
+	bool m_hasServerState = false;
+
 	// Watching the target accelerations (before jerk is applied) to track the ship state
 	Vec3 targetLinearAccel = ZERO;
 	Vec3 targetRollAccelDir = ZERO;
 	Vec3 targetPitchYawAccel = ZERO;
 
-	// Tracking ship position and orientation
-	Vec3 m_shipPosition = ZERO;
-	Quat m_shipOrientation = ZERO;
+	// Replicated ship state
+	SShipNetState m_netState;
+
+	// Snapshots of a ship piloted by someone else, client only
+	CShipSnapshotBuffer m_snapshots;
 };
 
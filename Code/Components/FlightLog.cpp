@@ -0,0 +1,147 @@
+// Copyright 2017-2019 Crytek GmbH / Crytek Group. All rights reserved.
+#include "FlightLog.h"
+
+#include <cstring>
+
+namespace
+{
+	struct SFlightLogWriter
+	{
+		std::vector<uint8_t>& out;
+
+		template<typename T>
+		void Value(const T& value)
+		{
+			const uint8_t* pBytes = reinterpret_cast<const uint8_t*>(&value);
+			out.insert(out.end(), pBytes, pBytes + sizeof(T));
+		}
+
+		void Value(const SFlightVec3& value) { Value(value.x); Value(value.y); Value(value.z); }
+	};
+
+	struct SFlightLogReader
+	{
+		const uint8_t* pCursor;
+		const uint8_t* pEnd;
+		bool valid = true;
+
+		template<typename T>
+		void Value(T& value)
+		{
+			if (!valid || (size_t)(pEnd - pCursor) < sizeof(T))
+			{
+				valid = false;
+				return;
+			}
+			memcpy(&value, pCursor, sizeof(T));
+			pCursor += sizeof(T);
+		}
+
+		void Value(SFlightVec3& value) { Value(value.x); Value(value.y); Value(value.z); }
+	};
+
+	// Lists the header fields once for both directions, THeader is const when writing
+	template<typename TStream, typename THeader>
+	void SerializeHeader(TStream& stream, THeader& header)
+	{
+		for (auto& axis : header.profile.axes)
+		{
+			stream.Value(axis.group);
+			stream.Value(axis.accel);
+			stream.Value(axis.velocityLimit);
+			stream.Value(axis.localDirection);
+		}
+		for (size_t group = 0; group < (size_t)EJerkGroup::Count; ++group)
+		{
+			stream.Value(header.profile.jerk[group]);
+			stream.Value(header.profile.jerkDecelRate[group]);
+		}
+		stream.Value(header.profile.linearBoost);
+		stream.Value(header.profile.angularBoost);
+		stream.Value(header.profile.logBase);
+		stream.Value(header.profile.logMaxDiscrepancy);
+		stream.Value(header.profile.correctionLookahead);
+
+		stream.Value(header.mass);
+		stream.Value(header.gravity);
+
+		stream.Value(header.body.position);
+		stream.Value(header.body.orientation.w);
+		stream.Value(header.body.orientation.x);
+		stream.Value(header.body.orientation.y);
+		stream.Value(header.body.orientation.z);
+		stream.Value(header.body.velocity);
+		stream.Value(header.body.angularVelocity);
+
+		for (auto& data : header.jerk)
+		{
+			stream.Value(data.currentJerkAccel);
+			stream.Value(data.targetJerkAccel);
+			stream.Value(data.state);
+		}
+	}
+}
+
+void CFlightLog::WriteHeader(const SFlightLogHeader& header, std::vector<uint8_t>& out)
+{
+	SFlightLogWriter writer{ out };
+	writer.Value(kMagic);
+	writer.Value(kVersion);
+	writer.Value((uint32_t)EShipAxis::Count);
+	SerializeHeader(writer, header);
+}
+
+void CFlightLog::WriteFrame(float frameTime, const SShipInputSnapshot& input, uint8_t* pOut)
+{
+	memcpy(pOut, &frameTime, sizeof(float));
+	pOut += sizeof(float);
+	memcpy(pOut, input.axes.data(), sizeof(float) * input.axes.size());
+	pOut += sizeof(float) * input.axes.size();
+	*pOut = input.modifiers.GetValue();
+}
+
+CFlightLog::EReadResult CFlightLog::Read(const uint8_t* pData, size_t size, SFlightLogHeader& outHeader, std::vector<SFlightLogFrame>& outFrames)
+{
+	SFlightLogReader reader{ pData, pData + size };
+
+	uint32_t magic = 0;
+	uint32_t version = 0;
+	uint32_t axisCount = 0;
+	reader.Value(magic);
+	reader.Value(version);
+	reader.Value(axisCount);
+	if (!reader.valid || magic != kMagic)
+		return EReadResult::NotALog;
+	if (version != kVersion || axisCount != (uint32_t)EShipAxis::Count)
+		return EReadResult::UnsupportedVersion;
+
+	SerializeHeader(reader, outHeader);
+	if (!reader.valid)
+		return EReadResult::NotALog;
+
+	const size_t frameCount = (size_t)(reader.pEnd - reader.pCursor) / kFrameSize;
+	outFrames.resize(frameCount);
+	for (SFlightLogFrame& frame : outFrames)
+	{
+		reader.Value(frame.frameTime);
+		for (float& axis : frame.input.axes)
+			reader.Value(axis);
+
+		uint8_t modifiers = 0;
+		reader.Value(modifiers);
+		frame.input.modifiers.SetValue(modifiers);
+	}
+
+	return EReadResult::Ok;
+}
+
+CHeadlessFlightModel CFlightLog::CreateReplayModel(const SFlightLogHeader& header, size_t shipCount)
+{
+	CHeadlessFlightModel model(header.profile, header.mass, header.gravity);
+	for (size_t i = 0; i < shipCount; ++i)
+	{
+		const size_t ship = model.AddShip(header.body);
+		model.SetJerkState(ship, header.jerk);
+	}
+	return model;
+}
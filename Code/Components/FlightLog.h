@@ -0,0 +1,53 @@
+// Copyright 2017-2021 Crytek GmbH / Crytek Group. All rights reserved.
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <Components/HeadlessFlightModel.h>
+
+// Everything the replay needs beside the input: the ship's profile and the state it started from
+struct SFlightLogHeader
+{
+	SFlightProfile profile;
+	float mass = 0.f;
+	SFlightVec3 gravity;
+
+	CHeadlessFlightModel::SBody body;
+	std::array<JerkAccelerationData, (size_t)EJerkGroup::Count> jerk = {};
+};
+
+struct SFlightLogFrame
+{
+	float frameTime = 0.f;
+	SShipInputSnapshot input;
+};
+
+////////////////////////////////////////////////////////
+// Binary layout of a flight recording, without engine dependency (written by CFlightRecorder, read by its replay).
+//   header: 'FLRC', uint32 version, uint32 axis count, then SFlightLogHeader field by field
+//   frame:  float frame time, float axes[axis count], uint8 modifier bits
+////////////////////////////////////////////////////////
+class CFlightLog
+{
+public:
+	static constexpr uint32_t kMagic = 'F' | ('L' << 8) | ('R' << 16) | ((uint32_t)'C' << 24); // "FLRC" in the file
+	static constexpr uint32_t kVersion = 2;
+	static constexpr size_t kFrameSize = sizeof(float) + sizeof(float) * (size_t)EShipAxis::Count + sizeof(uint8_t);
+
+	static void WriteHeader(const SFlightLogHeader& header, std::vector<uint8_t>& out);
+	static void WriteFrame(float frameTime, const SShipInputSnapshot& input, uint8_t* pOut);
+
+	enum class EReadResult
+	{
+		Ok,
+		NotALog,
+		UnsupportedVersion
+	};
+
+	// Frames past a truncated tail are dropped
+	static EReadResult Read(const uint8_t* pData, size_t size, SFlightLogHeader& outHeader, std::vector<SFlightLogFrame>& outFrames);
+
+	// Headless model flying the recorded ship, every ship starts from the recorded state
+	static CHeadlessFlightModel CreateReplayModel(const SFlightLogHeader& header, size_t shipCount);
+};
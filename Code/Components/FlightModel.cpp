@@ -0,0 +1,205 @@
+// Copyright 2017-2019 Crytek GmbH / Crytek Group. All rights reserved.
+#include "FlightModel.h"
+
+#include <algorithm>
+#include <cfloat>
+
+///////////////////////////////////////////////////////////////////////////
+// JERK
+///////////////////////////////////////////////////////////////////////////
+void CFlightModel::StepJerk(SFlightVec3& currentAccel, const SFlightVec3& targetAccel, float jerk, float jerkDecelRate, bool accelerating, float frameTime)
+{
+	// Accelerating: da/dt = |d|^0.3 * jerk * d, decelerating: da/dt = jerkDecelRate * d, with d = target - current.
+	// Both rates are evaluated and selected, the batched loop stays branch free
+	const SFlightVec3 delta = targetAccel - currentAccel;
+	const float accelRate = std::pow(delta.GetLength(), 0.3f) * jerk;
+	const float rate = (accelerating ? accelRate : jerkDecelRate) * frameTime;
+	currentAccel += delta * rate;
+}
+
+void CFlightModel::StepJerk(JerkAccelerationData& data, float frameTime)
+{
+	StepJerk(data.currentJerkAccel, data.targetJerkAccel, data.jerk, data.jerkDecelRate, data.state == EAccelState::Accelerating, frameTime);
+}
+
+SFlightVec3 CFlightModel::PredictVelocityChange(const JerkAccelerationData& data, const SFlightVec3& targetAccel, float horizon)
+{
+	// The gap d = target - current keeps its direction under both rates, only its length decays.
+	// The velocity change is target * T minus the integral of the gap over the horizon.
+	const SFlightVec3 delta = targetAccel - data.currentJerkAccel;
+	const float deltaLength = delta.GetLength();
+
+	if (horizon <= 0.f)
+		return SFlightVec3();
+	if (deltaLength <= FLT_EPSILON)
+		return targetAccel * horizon;
+
+	// Time integral of |d| over the horizon, divided by |d0|
+	float gapIntegral = horizon;
+	if (data.state == EAccelState::Accelerating)
+	{
+		// d|d|/dt = -k|d|^1.3  =>  |d|^-0.3 = |d0|^-0.3 + 0.3kt
+		const float k = data.jerk;
+		if (k > FLT_EPSILON)
+		{
+			const float c = std::pow(deltaLength, -0.3f);
+			const float cEnd = c + 0.3f * k * horizon;
+			gapIntegral = (std::pow(c, -7.f / 3.f) - std::pow(cEnd, -7.f / 3.f)) / (0.7f * k * deltaLength);
+		}
+	}
+	else
+	{
+		// d|d|/dt = -k|d|  =>  |d| = |d0| e^-kt
+		const float k = data.jerkDecelRate;
+		if (k > FLT_EPSILON)
+			gapIntegral = (1.f - std::exp(-k * horizon)) / k;
+	}
+
+	return targetAccel * horizon - delta * gapIntegral;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// FLIGHT MODES
+///////////////////////////////////////////////////////////////////////////
+float CFlightModel::LogScale(float discrepancyMagnitude, float maxDiscrepancy, float base)
+{
+	if (discrepancyMagnitude == 0.0f)
+		return 0.0f;
+
+	float logDiscrepancy = std::log(discrepancyMagnitude + 1.0f) / std::log(base);
+	float logMaxDiscrepancy = std::log(maxDiscrepancy + 1.0f) / std::log(base);
+
+	return logDiscrepancy / logMaxDiscrepancy;
+}
+
+void CFlightModel::ResolveModifiers(FlightModifierBitFlag& modifiers)
+{
+	if (modifiers.HasFlag(EFlightModifierFlag::Coupled))
+		modifiers.SetFlag(EFlightModifierFlag::Gravity);
+}
+
+float CFlightModel::GetLinearScale(const SFlightProfile& profile, const FlightModifierBitFlag& modifiers)
+{
+	return modifiers.HasFlag(EFlightModifierFlag::Boost) ? profile.linearBoost : 1.f;
+}
+
+float CFlightModel::GetAngularScale(const SFlightProfile& profile, const FlightModifierBitFlag& modifiers)
+{
+	return modifiers.HasFlag(EFlightModifierFlag::Boost) ? profile.angularBoost : 1.f;
+}
+
+void CFlightModel::ScaleInput(const SFlightProfile& profile, const SFlightMotion& motion, const SShipInputSnapshot& input, EJerkGroup group, SFlightVec3& outAccel, SFlightVec3& outVelocity)
+{
+	outAccel = SFlightVec3();
+	outVelocity = SFlightVec3();
+
+	for (size_t i = 0; i < (size_t)EShipAxis::Count; ++i)
+	{
+		const SFlightAxis& axis = profile.axes[i];
+		if (axis.group != group)
+			continue;
+
+		// Already normalized by the controller (mouse sensitivity included), clamped again for safety
+		const float value = std::min(std::max(input.axes[i], -1.f), 1.f);
+		const SFlightVec3& direction = motion.thrusterDirections[i];
+
+		outAccel += direction * (axis.accel * value);
+		outVelocity += direction * (axis.velocityLimit * value);
+	}
+}
+
+SFlightVec3 CFlightModel::CalculateCorrection(const SFlightProfile& profile, const SFlightMotion& motion, EJerkGroup group, const JerkAccelerationData& jerkData, const SFlightVec3& requestedVelocity, float frameTime)
+{
+	const SFlightVec3& currentVelocity = group == EJerkGroup::Linear ? motion.velocity : motion.angularVelocity;
+	const SFlightVec3 discrepancy = requestedVelocity - currentVelocity;
+	const SFlightVec3 discrepancyDirection = discrepancy.GetNormalizedSafe();
+
+	// Ensure the scaling factor does not exceed 1.0
+	const float scalingFactor = std::min(LogScale(discrepancy.GetLength(), profile.logMaxDiscrepancy, profile.logBase), 1.f);
+
+	SFlightVec3 correction;
+	for (size_t i = 0; i < (size_t)EShipAxis::Count; ++i)
+	{
+		const SFlightAxis& axis = profile.axes[i];
+		if (axis.group != group)
+			continue;
+
+		const SFlightVec3& direction = motion.thrusterDirections[i];
+		correction += direction * (axis.accel * direction.Dot(discrepancyDirection) * scalingFactor);
+	}
+
+	// Predicting velocity to account for overshoot, the jerk model is solved analytically over the lookahead horizon
+	const float lookahead = profile.correctionLookahead > 0.f ? profile.correctionLookahead : frameTime;
+	const SFlightVec3 predictedVelocity = currentVelocity + PredictVelocityChange(jerkData, correction, lookahead);
+
+	const float targetSpeed = requestedVelocity.GetLength();
+	const float predictedSpeed = predictedVelocity.GetLength();
+	if (predictedSpeed > targetSpeed + 0.1f)
+		correction *= targetSpeed / predictedSpeed;
+
+	return correction;
+}
+
+SFlightTargets CFlightModel::ComputeTargets(const SFlightProfile& profile, const SFlightMotion& motion, const SShipInputSnapshot& input, const std::array<JerkAccelerationData, (size_t)EJerkGroup::Count>& jerkData, float frameTime)
+{
+	SFlightTargets targets;
+
+	for (size_t group = 0; group < (size_t)EJerkGroup::Count; ++group)
+	{
+		SFlightVec3 accel, velocity;
+		ScaleInput(profile, motion, input, (EJerkGroup)group, accel, velocity);
+
+		if (input.modifiers.HasFlag(EFlightModifierFlag::Coupled))
+		{
+			// The linear state follows the requested velocity, the angular groups keep the state they had
+			targets.accel[group] = CalculateCorrection(profile, motion, (EJerkGroup)group, jerkData[group], velocity, frameTime);
+			if ((EJerkGroup)group == EJerkGroup::Linear)
+				targets.state[group] = velocity.IsZero() ? EAccelState::Decelerating : EAccelState::Accelerating;
+			else
+				targets.state[group] = jerkData[group].state;
+		}
+		else
+		{
+			// Based on input, not ship motion
+			targets.accel[group] = accel;
+			targets.state[group] = accel.IsZero() ? EAccelState::Decelerating : EAccelState::Accelerating;
+		}
+	}
+
+	return targets;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// FLIGHT MODIFIERS
+///////////////////////////////////////////////////////////////////////////
+SFlightVec3 CFlightModel::GetAntiGravityForce(const SFlightProfile& profile, const SFlightMotion& motion, const SFlightVec3& gravity)
+{
+	const SFlightVec3 gravityDirection = gravity.GetNormalizedSafe();
+	const SFlightVec3 antiGravityForce = -gravity * motion.mass;
+
+	// First pass: total alignment of the linear thrusters with gravity (unit directions, 1 = perfect / -1 = anti)
+	float totalAlignment = 0.f;
+	for (size_t i = 0; i < (size_t)EShipAxis::Count; ++i)
+	{
+		if (profile.axes[i].group != EJerkGroup::Linear)
+			continue;
+
+		const float alignment = motion.thrusterDirections[i].Dot(gravityDirection);
+		if (alignment > 0.f)
+			totalAlignment += alignment;
+	}
+
+	// Second pass: every aligned thruster takes its share of the force
+	SFlightVec3 totalScaledAntiGravityForce;
+	for (size_t i = 0; i < (size_t)EShipAxis::Count; ++i)
+	{
+		if (profile.axes[i].group != EJerkGroup::Linear)
+			continue;
+
+		const float alignment = motion.thrusterDirections[i].Dot(gravityDirection);
+		if (alignment > 0.f)
+			totalScaledAntiGravityForce += antiGravityForce * (alignment / totalAlignment);
+	}
+
+	return totalScaledAntiGravityForce;
+}
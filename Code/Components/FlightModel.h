@@ -0,0 +1,153 @@
+// Copyright 2017-2021 Crytek GmbH / Crytek Group. All rights reserved.
+#pragma once
+#include <array>
+#include <cmath>
+
+#include <Components/ShipInput.h>
+
+// Vector of the flight model. The model does not depend on the engine, so the benchmark and the replayer build without it.
+struct SFlightVec3
+{
+	float x = 0.f;
+	float y = 0.f;
+	float z = 0.f;
+
+	SFlightVec3() = default;
+	SFlightVec3(float x_, float y_, float z_) : x(x_), y(y_), z(z_) {}
+
+	SFlightVec3 operator+(const SFlightVec3& other) const { return SFlightVec3(x + other.x, y + other.y, z + other.z); }
+	SFlightVec3 operator-(const SFlightVec3& other) const { return SFlightVec3(x - other.x, y - other.y, z - other.z); }
+	SFlightVec3 operator-() const { return SFlightVec3(-x, -y, -z); }
+	SFlightVec3 operator*(float scale) const { return SFlightVec3(x * scale, y * scale, z * scale); }
+	SFlightVec3 operator/(float scale) const { return *this * (1.f / scale); }
+	SFlightVec3& operator+=(const SFlightVec3& other) { x += other.x; y += other.y; z += other.z; return *this; }
+	SFlightVec3& operator-=(const SFlightVec3& other) { x -= other.x; y -= other.y; z -= other.z; return *this; }
+	SFlightVec3& operator*=(float scale) { x *= scale; y *= scale; z *= scale; return *this; }
+
+	float Dot(const SFlightVec3& other) const { return x * other.x + y * other.y + z * other.z; }
+	float GetLength() const { return std::sqrt(Dot(*this)); }
+	bool IsZero() const { return x == 0.f && y == 0.f && z == 0.f; }
+
+	// Zero stays zero
+	SFlightVec3 GetNormalizedSafe() const
+	{
+		const float length = GetLength();
+		return length > 0.f ? *this / length : SFlightVec3();
+	}
+};
+
+enum class EAccelState
+{
+	Accelerating,
+	Decelerating
+};
+
+// Axis groups sharing a jerk state
+enum class EJerkGroup : uint8_t
+{
+	Linear = 0,
+	Roll,
+	PitchYaw,
+	Count
+};
+
+// Jerk state of one axis group. The flight batch stores these as structure-of-arrays, this is the per-ship view of a single entry.
+struct JerkAccelerationData
+{
+	float jerk = 0.f;
+	float jerkDecelRate = 0.f;
+	SFlightVec3 currentJerkAccel;
+	SFlightVec3 targetJerkAccel;
+	EAccelState state = EAccelState::Decelerating;
+};
+
+// One pilot axis of a ship: the group it drives, its acceleration and velocity limit, and its thrust direction in ship space
+struct SFlightAxis
+{
+	EJerkGroup group = EJerkGroup::Linear;
+	float accel = 0.f;
+	float velocityLimit = 0.f;
+	SFlightVec3 localDirection;
+};
+
+// Performance of a ship, everything the flight model needs beside its state. Angular values are in radians.
+struct SFlightProfile
+{
+	std::array<SFlightAxis, (size_t)EShipAxis::Count> axes = {};
+	std::array<float, (size_t)EJerkGroup::Count> jerk = {};
+	std::array<float, (size_t)EJerkGroup::Count> jerkDecelRate = {};
+
+	float linearBoost = 1.f;
+	float angularBoost = 1.f;
+
+	// Coupled mode
+	float logBase = 2.f;
+	float logMaxDiscrepancy = 1.f;
+	float correctionLookahead = 0.f; // 0 uses the frame time
+
+	const SFlightAxis& GetAxis(EShipAxis axis) const { return axes[(size_t)axis]; }
+};
+
+// State of a ship for one flight step, in world space
+struct SFlightMotion
+{
+	SFlightVec3 velocity;
+	SFlightVec3 angularVelocity;
+	float mass = 0.f;
+
+	// Thrust direction of every axis, rotated once per step
+	std::array<SFlightVec3, (size_t)EShipAxis::Count> thrusterDirections = {};
+
+	const SFlightVec3& GetThrusterDirection(EShipAxis axis) const { return thrusterDirections[(size_t)axis]; }
+};
+
+// Target accelerations of every group for the batched step
+struct SFlightTargets
+{
+	std::array<SFlightVec3, (size_t)EJerkGroup::Count> accel = {};
+	std::array<EAccelState, (size_t)EJerkGroup::Count> state = { EAccelState::Decelerating, EAccelState::Decelerating, EAccelState::Decelerating };
+};
+
+////////////////////////////////////////////////////////
+// Flight math shared by the flight controller, the flight batch, the client replay and the headless tools.
+// Stateless: the jerk state lives in the batch, the rigid body in physics (or the headless mock body).
+////////////////////////////////////////////////////////
+class CFlightModel
+{
+public:
+	// Flight impulses used to be sent to physics as two identical actions and every ship profile is tuned around it, the conversion keeps that gain
+	static constexpr float kImpulseGain = 2.f;
+
+	// Impulse of one lane over a step, the only acceleration to impulse conversion
+	static SFlightVec3 AccelToImpulse(const SFlightVec3& accel, float mass, float scale, float frameTime)
+	{
+		return accel * (mass * frameTime * scale * kImpulseGain);
+	}
+
+	// One step of a single lane, the only jerk integrator
+	static void StepJerk(SFlightVec3& currentAccel, const SFlightVec3& targetAccel, float jerk, float jerkDecelRate, bool accelerating, float frameTime);
+	static void StepJerk(JerkAccelerationData& data, float frameTime);
+
+	// Velocity gained over the horizon if the group chased targetAccel from its current jerk state, solved in closed form
+	static SFlightVec3 PredictVelocityChange(const JerkAccelerationData& data, const SFlightVec3& targetAccel, float horizon);
+
+	// Logarithmic scaling of the corrective acceleration (Coupled mode), for a smoother flying experience
+	static float LogScale(float discrepancyMagnitude, float maxDiscrepancy, float base);
+
+	// Coupled mode enforces the gravity assist
+	static void ResolveModifiers(FlightModifierBitFlag& modifiers);
+	static float GetLinearScale(const SFlightProfile& profile, const FlightModifierBitFlag& modifiers);
+	static float GetAngularScale(const SFlightProfile& profile, const FlightModifierBitFlag& modifiers);
+
+	// Input of a group scaled by the axes' acceleration and velocity limit, along their world thrust directions
+	static void ScaleInput(const SFlightProfile& profile, const SFlightMotion& motion, const SShipInputSnapshot& input, EJerkGroup group, SFlightVec3& outAccel, SFlightVec3& outVelocity);
+
+	// Coupled mode: acceleration closing the gap to the requested velocity, scaled down when the jerk state would overshoot it
+	static SFlightVec3 CalculateCorrection(const SFlightProfile& profile, const SFlightMotion& motion, EJerkGroup group, const JerkAccelerationData& jerkData, const SFlightVec3& requestedVelocity, float frameTime);
+
+	// Targets of every group for the flight mode picked by the modifiers. jerkData is the state of each group before the step.
+	static SFlightTargets ComputeTargets(const SFlightProfile& profile, const SFlightMotion& motion, const SShipInputSnapshot& input, const std::array<JerkAccelerationData, (size_t)EJerkGroup::Count>& jerkData, float frameTime);
+
+	// Force compensating the gravity pull, spread over the linear thrusters facing it
+	static SFlightVec3 GetAntiGravityForce(const SFlightProfile& profile, const SFlightMotion& motion, const SFlightVec3& gravity);
+};
@@ -39,6 +39,17 @@ public:
         return (m_modifierValue & (int)multiFlag) != 0;
     }
 
+    // Raw bits, for recording and network packing
+    uint8_t GetValue() const
+    {
+        return m_modifierValue;
+    }
+
+    void SetValue(uint8_t value)
+    {
+        m_modifierValue = value;
+    }
+
 private:
     uint8_t m_modifierValue = 0;
 };
\ No newline at end of file
@@ -0,0 +1,200 @@
+// Copyright 2017-2019 Crytek GmbH / Crytek Group. All rights reserved.
+#include "StdAfx.h"
+#include "FlightRecorder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <CrySystem/ConsoleRegistration.h>
+#include <CrySystem/IConsole.h>
+#include <CrySystem/File/ICryPak.h>
+
+namespace
+{
+	constexpr const char* kDefaultPath = "%USER%/flight_recording.flr";
+}
+
+CFlightRecorder::~CFlightRecorder()
+{
+	StopRecording();
+}
+
+bool CFlightRecorder::StartRecording(const char* szPath)
+{
+	StopRecording();
+
+	m_pFile = gEnv->pCryPak->FOpen(szPath, "wb");
+	if (!m_pFile)
+	{
+		CryLogAlways("[FlightRecorder] could not open %s", szPath);
+		return false;
+	}
+
+	m_buffer.clear();
+	m_buffer.reserve(kBufferSize);
+	m_frameCount = 0;
+	m_headerWritten = false;
+
+	CryLogAlways("[FlightRecorder] recording to %s", szPath);
+	return true;
+}
+
+void CFlightRecorder::StopRecording()
+{
+	if (!m_pFile)
+		return;
+
+	Flush();
+	gEnv->pCryPak->FClose(m_pFile);
+	m_pFile = nullptr;
+
+	CryLogAlways("[FlightRecorder] stopped, %u frames recorded", m_frameCount);
+}
+
+void CFlightRecorder::RecordHeader(const SFlightLogHeader& header)
+{
+	if (!m_pFile)
+		return;
+
+	std::vector<uint8> data;
+	CFlightLog::WriteHeader(header, data);
+	Write(data.data(), data.size());
+	m_headerWritten = true;
+}
+
+void CFlightRecorder::RecordFrame(float frameTime, const SShipInputSnapshot& input)
+{
+	if (!m_pFile || !m_headerWritten)
+		return;
+
+	uint8 frame[CFlightLog::kFrameSize];
+	CFlightLog::WriteFrame(frameTime, input, frame);
+
+	Write(frame, CFlightLog::kFrameSize);
+	++m_frameCount;
+}
+
+void CFlightRecorder::Write(const void* pData, size_t size)
+{
+	if (m_buffer.size() + size > kBufferSize)
+		Flush();
+
+	const uint8* pBytes = static_cast<const uint8*>(pData);
+	m_buffer.insert(m_buffer.end(), pBytes, pBytes + size);
+}
+
+void CFlightRecorder::Flush()
+{
+	if (m_pFile && !m_buffer.empty())
+		gEnv->pCryPak->FWrite(m_buffer.data(), 1, m_buffer.size(), m_pFile);
+
+	m_buffer.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////
+// CONSOLE
+///////////////////////////////////////////////////////////////////////////
+void CFlightRecorder::RegisterConsoleCommands()
+{
+	REGISTER_COMMAND("flight_record", &CFlightRecorder::RecordCommand, VF_NULL, "Records the local pilot's flight input. Usage: flight_record [file=%USER%/flight_recording.flr]");
+	REGISTER_COMMAND("flight_record_stop", &CFlightRecorder::StopCommand, VF_NULL, "Stops the flight input recording");
+	REGISTER_COMMAND("flight_replay", &CFlightRecorder::ReplayCommand, VF_CHEAT, "Replays a flight input recording headless. Usage: flight_replay [file=%USER%/flight_recording.flr] [ships=1]");
+}
+
+void CFlightRecorder::UnregisterConsoleCommands()
+{
+	GetInstance().StopRecording();
+
+	if (gEnv->pConsole)
+	{
+		gEnv->pConsole->RemoveCommand("flight_record");
+		gEnv->pConsole->RemoveCommand("flight_record_stop");
+		gEnv->pConsole->RemoveCommand("flight_replay");
+	}
+}
+
+void CFlightRecorder::RecordCommand(IConsoleCmdArgs* pArgs)
+{
+	GetInstance().StartRecording(pArgs->GetArgCount() > 1 ? pArgs->GetArg(1) : kDefaultPath);
+}
+
+void CFlightRecorder::StopCommand(IConsoleCmdArgs* pArgs)
+{
+	GetInstance().StopRecording();
+}
+
+void CFlightRecorder::ReplayCommand(IConsoleCmdArgs* pArgs)
+{
+	const char* szPath = pArgs->GetArgCount() > 1 ? pArgs->GetArg(1) : kDefaultPath;
+	const int shipCount = pArgs->GetArgCount() > 2 ? std::max(atoi(pArgs->GetArg(2)), 1) : 1;
+
+	// Read the whole log at once, it is a few KB per minute of flight
+	FILE* pFile = gEnv->pCryPak->FOpen(szPath, "rb");
+	if (!pFile)
+	{
+		CryLogAlways("[FlightRecorder] could not open %s", szPath);
+		return;
+	}
+
+	std::vector<uint8> data(gEnv->pCryPak->FGetSize(pFile));
+	const size_t readSize = gEnv->pCryPak->FReadRaw(data.data(), 1, data.size(), pFile);
+	gEnv->pCryPak->FClose(pFile);
+
+	SFlightLogHeader header;
+	std::vector<SFlightLogFrame> frames;
+	switch (CFlightLog::Read(data.data(), readSize, header, frames))
+	{
+	case CFlightLog::EReadResult::NotALog:
+		CryLogAlways("[FlightRecorder] %s is not a flight recording", szPath);
+		return;
+	case CFlightLog::EReadResult::UnsupportedVersion:
+		CryLogAlways("[FlightRecorder] %s has an unsupported format, expected version %u", szPath, CFlightLog::kVersion);
+		return;
+	default:
+		break;
+	}
+
+	// Every ship replays the same input from the recorded state, more ships only scale the workload
+	CHeadlessFlightModel model = CFlightLog::CreateReplayModel(header, (size_t)shipCount);
+
+	using Clock = std::chrono::high_resolution_clock;
+	double totalNs = 0.0;
+	double maxNs = 0.0;
+	float simulatedTime = 0.f;
+	float nextSample = 0.f;
+
+	const size_t frameCount = frames.size();
+	CryLogAlways("[FlightRecorder] replaying %s: %u frames, %d ship(s), mass %.0f", szPath, (uint32)frameCount, shipCount, header.mass);
+
+	for (const SFlightLogFrame& frame : frames)
+	{
+		const float frameTime = frame.frameTime;
+		if (frameTime <= 0.f)
+			continue;
+
+		const Clock::time_point start = Clock::now();
+
+		for (int i = 0; i < shipCount; ++i)
+			model.SetInput(i, frame.input);
+		model.Step(frameTime);
+
+		const double elapsedNs = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+		totalNs += elapsedNs;
+		maxNs = std::max(maxNs, elapsedNs);
+		simulatedTime += frameTime;
+
+		// Trajectory, once per simulated second
+		if (simulatedTime >= nextSample)
+		{
+			const CHeadlessFlightModel::SBody& body = model.GetBody(0);
+			CryLogAlways("[FlightRecorder] t=%7.2f | pos (%9.2f %9.2f %9.2f) | speed %7.2f | ang speed %6.2f | step %8.0f ns",
+				simulatedTime, body.position.x, body.position.y, body.position.z, body.velocity.GetLength(), body.angularVelocity.GetLength(), elapsedNs);
+			nextSample += 1.f;
+		}
+	}
+
+	if (frameCount > 0)
+	{
+		CryLogAlways("[FlightRecorder] %.2f s simulated | avg %.1f ns/frame | max %.1f ns/frame | %.2f ns/ship/frame",
+			simulatedTime, totalNs / frameCount, maxNs, totalNs / ((double)frameCount * shipCount));
+	}
+}
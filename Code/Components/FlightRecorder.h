@@ -0,0 +1,59 @@
+// Copyright 2017-2021 Crytek GmbH / Crytek Group. All rights reserved.
+#pragma once
+#include <vector>
+
+#include <Components/FlightLog.h>
+
+struct IConsoleCmdArgs;
+
+////////////////////////////////////////////////////////
+// Records the input reaching the local pilot's flight controller (frame time, every axis, modifier bits) into a compact binary log
+// headed by the ship's profile and starting state (CFlightLog), and replays such a log through the headless flight model.
+//   flight_record [file]           starts recording, flight_record_stop ends it
+//   flight_replay [file] [ships]   replays the log and reports the trajectory and per-frame cost
+////////////////////////////////////////////////////////
+class CFlightRecorder
+{
+public:
+	static CFlightRecorder& GetInstance()
+	{
+		static CFlightRecorder instance;
+		return instance;
+	}
+
+	bool IsRecording() const { return m_pFile != nullptr; }
+
+	// The controller writes the header on its first recorded step, frames before it are dropped
+	bool NeedsHeader() const { return m_pFile != nullptr && !m_headerWritten; }
+	void RecordHeader(const SFlightLogHeader& header);
+
+	// Called by the flight controller with the input of the step
+	void RecordFrame(float frameTime, const SShipInputSnapshot& input);
+
+	bool StartRecording(const char* szPath);
+	void StopRecording();
+
+	static void RegisterConsoleCommands();
+	static void UnregisterConsoleCommands();
+
+private:
+	CFlightRecorder() = default;
+	~CFlightRecorder();
+	CFlightRecorder(const CFlightRecorder&) = delete;
+	CFlightRecorder& operator=(const CFlightRecorder&) = delete;
+
+	// Frames are written in blocks, the file is only touched when the buffer is full
+	static constexpr size_t kBufferSize = 64 * 1024;
+
+	void Write(const void* pData, size_t size);
+	void Flush();
+
+	static void RecordCommand(IConsoleCmdArgs* pArgs);
+	static void StopCommand(IConsoleCmdArgs* pArgs);
+	static void ReplayCommand(IConsoleCmdArgs* pArgs);
+
+	FILE* m_pFile = nullptr;
+	std::vector<uint8> m_buffer;
+	uint32 m_frameCount = 0;
+	bool m_headerWritten = false;
+};
@@ -0,0 +1,510 @@
+// Copyright 2017-2019 Crytek GmbH / Crytek Group. All rights reserved.
+#include "StdAfx.h"
+#include "FlightSystem.h"
+
+#include <algorithm>
+#include <CryPhysics/physinterface.h>
+#include <CrySystem/ConsoleRegistration.h>
+#include <CrySystem/IConsole.h>
+
+#include <Components/FlightController.h>
+
+int CFlightSystem::s_fixedRate = 0;
+int CFlightSystem::s_netTickRate = 60;
+int CFlightSystem::s_maxCatchUpSteps = 4;
+int CFlightSystem::s_physicsStep = 0;
+int CFlightSystem::s_inputSendRate = 30;
+int CFlightSystem::s_snapshotRate = 30;
+float CFlightSystem::s_interpolationDelay = 0.1f;
+float CFlightSystem::s_maxExtrapolation = 0.25f;
+
+///////////////////////////////////////////////////////////////////////////
+// REGISTRATION
+///////////////////////////////////////////////////////////////////////////
+void CFlightSystem::Resize(size_t size)
+{
+	m_batch.Resize(size);
+	m_physicsBatch.Resize(size);
+	m_active.resize(size, 0);
+	m_accelOverridden.resize(size, 0);
+	m_physicsDriven.resize(size, 0);
+	m_physicsFlight.resize(size, 0);
+	m_holdForce.resize(size, Vec3(ZERO));
+	m_queuedLinearImpulse.resize(size, Vec3(ZERO));
+	m_queuedAngularImpulse.resize(size, Vec3(ZERO));
+	m_controllers.resize(size, nullptr);
+}
+
+CFlightSystem::SlotId CFlightSystem::RegisterShip(CFlightController* pController)
+{
+	CryAutoLock<CryCriticalSection> lock(m_physicsLock);
+
+	SlotId slot;
+	if (!m_freeSlots.empty())
+	{
+		// Reuse a released slot so the arrays stay dense
+		slot = m_freeSlots.back();
+		m_freeSlots.pop_back();
+	}
+	else
+	{
+		slot = (SlotId)m_controllers.size();
+		Resize(m_controllers.size() + 1);
+	}
+
+	m_controllers[slot] = pController;
+	ResetJerk(slot);
+	SetImpulseScale(slot, 0.f, 1.f, 1.f);
+	return slot;
+}
+
+void CFlightSystem::UnregisterShip(SlotId slot)
+{
+	CryAutoLock<CryCriticalSection> lock(m_physicsLock);
+
+	if (slot >= m_controllers.size())
+		return;
+
+	for (auto it = m_physicsSlots.begin(); it != m_physicsSlots.end(); ++it)
+	{
+		if (it->second == slot)
+		{
+			m_physicsSlots.erase(it);
+			break;
+		}
+	}
+
+	// Zero mass keeps the slot inert while it waits to be reused
+	m_controllers[slot] = nullptr;
+	m_active[slot] = 0;
+	m_physicsDriven[slot] = 0;
+	m_physicsFlight[slot] = 0;
+	m_batch.SetImpulseScale(slot, 0.f, 1.f, 1.f);
+	m_physicsBatch.SetImpulseScale(slot, 0.f, 1.f, 1.f);
+	ResetJerk(slot);
+	m_physicsBatch.ResetJerk(slot);
+	m_freeSlots.push_back(slot);
+}
+
+///////////////////////////////////////////////////////////////////////////
+// PER SHIP PARAMETERS
+///////////////////////////////////////////////////////////////////////////
+void CFlightSystem::SetJerkRates(SlotId slot, EJerkGroup group, float jerk, float jerkDecelRate)
+{
+	m_batch.SetJerkRates(slot, group, jerk, jerkDecelRate);
+}
+
+void CFlightSystem::ResetJerk(SlotId slot)
+{
+	m_batch.ResetJerk(slot);
+	m_accelOverridden[slot] = 1;
+
+	CryAutoLock<CryCriticalSection> lock(m_physicsLock);
+	m_holdForce[slot] = ZERO;
+	m_queuedLinearImpulse[slot] = ZERO;
+	m_queuedAngularImpulse[slot] = ZERO;
+}
+
+void CFlightSystem::SetImpulseScale(SlotId slot, float mass, float linearScale, float angularScale)
+{
+	m_batch.SetImpulseScale(slot, mass, linearScale, angularScale);
+}
+
+void CFlightSystem::SetTargets(SlotId slot, const SFlightTargets& targets)
+{
+	for (size_t group = 0; group < (size_t)EJerkGroup::Count; ++group)
+	{
+		m_batch.SetTargetAccel(slot, (EJerkGroup)group, targets.accel[group], targets.state[group]);
+	}
+}
+
+void CFlightSystem::SetCurrentAccel(SlotId slot, EJerkGroup group, const Vec3& currentAccel)
+{
+	m_batch.SetCurrentAccel(slot, group, ToFlightVec3(currentAccel));
+	m_accelOverridden[slot] = 1;
+}
+
+Vec3 CFlightSystem::GetCurrentAccel(SlotId slot, EJerkGroup group) const
+{
+	return ToVec3(m_batch.GetCurrentAccel(slot, group));
+}
+
+std::array<JerkAccelerationData, (size_t)CFlightSystem::EJerkGroup::Count> CFlightSystem::GetJerkData(SlotId slot) const
+{
+	return m_batch.GetJerkData(slot);
+}
+
+///////////////////////////////////////////////////////////////////////////
+// STEPPING
+///////////////////////////////////////////////////////////////////////////
+void CFlightSystem::Update(float frameTime)
+{
+	if (gEnv->IsEditing() || frameTime <= 0.f)
+		return;
+
+	const size_t count = m_controllers.size();
+
+	// Remote ships are played back from their snapshots once per frame, in every step mode
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (m_controllers[i])
+			m_controllers[i]->UpdateSnapshotPlayback(frameTime);
+	}
+
+	// Physics substeps are not aligned with the pilot inputs, networked games keep the fixed tick
+	const bool physicsStep = s_physicsStep != 0 && !IsNetworked();
+	if (physicsStep != m_physicsStepActive)
+		SetPhysicsStepActive(physicsStep);
+
+	if (physicsStep)
+	{
+		UpdatePhysicsStep(frameTime);
+		return;
+	}
+
+	const int fixedRate = GetFixedRate();
+	if (fixedRate <= 0)
+	{
+		// Switching back to variable rate, put the geometry back on the physics transform
+		if (m_wasFixedRate)
+		{
+			for (CFlightController* pController : m_controllers)
+			{
+				if (pController)
+					pController->ResetPresentation();
+			}
+			m_wasFixedRate = false;
+			m_ticksAwaitingPose = false;
+			m_accumulator = 0.f;
+		}
+
+		Tick(frameTime);
+		return;
+	}
+
+	m_wasFixedRate = true;
+
+	// The ticks of the previous frame have been through the physics step by now, their pose is the one physics settled on
+	if (m_ticksAwaitingPose)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (m_controllers[i] && !m_controllers[i]->IsPlayingSnapshots())
+				m_controllers[i]->RecordFlightPose();
+		}
+		m_ticksAwaitingPose = false;
+	}
+
+	const float fixedStep = 1.f / (float)fixedRate;
+	const int maxSteps = std::max(s_maxCatchUpSteps, 1);
+	m_accumulator += frameTime;
+
+	int steps = 0;
+	while (m_accumulator >= fixedStep && steps < maxSteps)
+	{
+		Tick(fixedStep);
+		m_accumulator -= fixedStep;
+		++steps;
+	}
+	m_ticksAwaitingPose |= steps > 0;
+
+	// Too far behind, drop the backlog instead of spiralling
+	if (m_accumulator >= fixedStep)
+		m_accumulator = fmodf(m_accumulator, fixedStep);
+
+	// Ships played back from snapshots are already at an interpolated pose, an offset on top would lag them behind
+	const float alpha = m_accumulator / fixedStep;
+	for (size_t i = 0; i < count; ++i)
+	{
+		CFlightController* pController = m_controllers[i];
+		if (!pController)
+			continue;
+
+		if (pController->IsPlayingSnapshots())
+			pController->ResetPresentation();
+		else
+			pController->UpdatePresentation(alpha);
+	}
+}
+
+int CFlightSystem::GetFixedRate()
+{
+	if (s_fixedRate > 0)
+		return s_fixedRate;
+
+	return IsNetworked() ? std::max(s_netTickRate, 1) : 0;
+}
+
+bool CFlightSystem::IsNetworked()
+{
+	return gEnv->bMultiplayer || !gEnv->bServer;
+}
+
+void CFlightSystem::Tick(float frameTime)
+{
+	const size_t count = m_controllers.size();
+
+	// Gather: every piloted ship publishes its targets into its slot
+	for (size_t i = 0; i < count; ++i)
+	{
+		m_active[i] = m_controllers[i] && m_controllers[i]->PrepareFlightStep(frameTime) ? 1 : 0;
+	}
+
+	// Only the runs of active slots, the jerk state of parked ships stays where it was left
+	for (size_t begin = 0; begin < count; ++begin)
+	{
+		if (!m_active[begin])
+			continue;
+
+		size_t end = begin + 1;
+		while (end < count && m_active[end])
+			++end;
+
+		m_batch.StepRange(frameTime, begin, end);
+		begin = end;
+	}
+
+	// Commit: only ships that asked for it get their impulse applied
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (m_active[i])
+		{
+			m_controllers[i]->CommitFlightStep(ToVec3(m_batch.GetLinearImpulse(i)), ToVec3(m_batch.GetAngularImpulse(i)), frameTime);
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////
+// PHYSICS STEP
+///////////////////////////////////////////////////////////////////////////
+void CFlightSystem::SetPhysicsStepActive(bool active)
+{
+	if (!gEnv->pPhysicalWorld)
+		return;
+
+	if (active)
+	{
+		// bLogged = 0, the listener runs on the physics thread right after each entity step
+		gEnv->pPhysicalWorld->AddEventClient(EventPhysPostStep::id, &CFlightSystem::OnPhysicsPostStep, 0);
+		m_accumulator = 0.f;
+		m_wasFixedRate = false;
+		m_ticksAwaitingPose = false;
+	}
+	else
+	{
+		gEnv->pPhysicalWorld->RemoveEventClient(EventPhysPostStep::id, &CFlightSystem::OnPhysicsPostStep, 0);
+	}
+
+	{
+		CryAutoLock<CryCriticalSection> lock(m_physicsLock);
+
+		// Entering seeds the physics batch from the main thread one, leaving carries the integrated state back
+		const SlotId count = (SlotId)m_controllers.size();
+		for (SlotId slot = 0; slot < count; ++slot)
+		{
+			if (active)
+			{
+				m_physicsBatch.CopyInputs(m_batch, slot);
+				m_physicsBatch.CopyCurrentAccel(m_batch, slot);
+			}
+			else
+			{
+				m_batch.CopyCurrentAccel(m_physicsBatch, slot);
+			}
+		}
+		std::fill(m_accelOverridden.begin(), m_accelOverridden.end(), 0);
+
+		m_physicsSlots.clear();
+		std::fill(m_physicsDriven.begin(), m_physicsDriven.end(), 0);
+		std::fill(m_physicsFlight.begin(), m_physicsFlight.end(), 0);
+		std::fill(m_holdForce.begin(), m_holdForce.end(), Vec3(ZERO));
+		std::fill(m_queuedLinearImpulse.begin(), m_queuedLinearImpulse.end(), Vec3(ZERO));
+		std::fill(m_queuedAngularImpulse.begin(), m_queuedAngularImpulse.end(), Vec3(ZERO));
+	}
+
+	// Outside the lock, SetParams can wait on the physics thread
+	for (CFlightController* pController : m_controllers)
+	{
+		if (pController)
+		{
+			pController->ResetPresentation();
+			pController->SetPostStepMonitoring(active);
+		}
+	}
+
+	m_physicsStepActive = active;
+}
+
+void CFlightSystem::UpdatePhysicsStep(float frameTime)
+{
+	const size_t count = m_controllers.size();
+
+	{
+		CryAutoLock<CryCriticalSection> lock(m_physicsLock);
+		SnapshotPhysicsBatch();
+	}
+
+	// Gather only, the targets are chased by every physics substep until the next frame.
+	// This queries and acts on physics, so it must not hold the lock. It only touches m_batch, published below in one go.
+	for (size_t i = 0; i < count; ++i)
+	{
+		CFlightController* pController = m_controllers[i];
+		m_active[i] = pController && pController->PrepareFlightStep(frameTime) ? 1 : 0;
+
+		if (pController)
+			pController->SetPostStepMonitoring(true);
+	}
+
+	{
+		CryAutoLock<CryCriticalSection> lock(m_physicsLock);
+		PublishPhysicsBatch();
+
+		m_physicsSlots.clear();
+		for (size_t i = 0; i < count; ++i)
+		{
+			CFlightController* pController = m_controllers[i];
+			m_physicsDriven[i] = m_active[i];
+			m_physicsFlight[i] = m_active[i] && pController->IsApplyingFlightImpulse() ? 1 : 0;
+
+			IPhysicalEntity* pPhysicalEntity = pController ? pController->GetEntity()->GetPhysicalEntity() : nullptr;
+			if (pPhysicalEntity)
+				m_physicsSlots.insert(std::make_pair(pPhysicalEntity, (SlotId)i));
+		}
+	}
+
+	// Anti-gravity becomes the held force, the rest of the wrench is queued for the next substep. Debug output stays on the main thread.
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (m_active[i])
+		{
+			m_controllers[i]->CommitFlightModifiers(frameTime);
+			m_controllers[i]->CommitWrench();
+		}
+	}
+}
+
+void CFlightSystem::SnapshotPhysicsBatch()
+{
+	const SlotId count = (SlotId)m_controllers.size();
+	for (SlotId slot = 0; slot < count; ++slot)
+	{
+		// An override not published yet wins over what the physics thread integrated
+		if (m_physicsDriven[slot] && !m_accelOverridden[slot])
+			m_batch.CopyCurrentAccel(m_physicsBatch, slot);
+	}
+}
+
+void CFlightSystem::PublishPhysicsBatch()
+{
+	const SlotId count = (SlotId)m_controllers.size();
+	for (SlotId slot = 0; slot < count; ++slot)
+	{
+		m_physicsBatch.CopyInputs(m_batch, slot);
+
+		if (m_accelOverridden[slot])
+		{
+			m_physicsBatch.CopyCurrentAccel(m_batch, slot);
+			m_accelOverridden[slot] = 0;
+		}
+	}
+}
+
+void CFlightSystem::SetHoldForce(SlotId slot, const Vec3& force)
+{
+	CryAutoLock<CryCriticalSection> lock(m_physicsLock);
+	m_holdForce[slot] = force;
+}
+
+void CFlightSystem::QueueImpulse(SlotId slot, const Vec3& linearImpulse, const Vec3& angularImpulse)
+{
+	CryAutoLock<CryCriticalSection> lock(m_physicsLock);
+	m_queuedLinearImpulse[slot] += linearImpulse;
+	m_queuedAngularImpulse[slot] += angularImpulse;
+}
+
+void CFlightSystem::StepPhysicalEntity(IPhysicalEntity* pPhysicalEntity, float frameTime)
+{
+	if (frameTime <= 0.f)
+		return;
+
+	CryAutoLock<CryCriticalSection> lock(m_physicsLock);
+
+	const auto it = m_physicsSlots.find(pPhysicalEntity);
+	if (it == m_physicsSlots.end() || !m_physicsDriven[it->second])
+		return;
+
+	const SlotId slot = it->second;
+	Vec3 linearImpulse = m_holdForce[slot] * frameTime + m_queuedLinearImpulse[slot];
+	Vec3 angularImpulse = m_queuedAngularImpulse[slot];
+	m_queuedLinearImpulse[slot] = ZERO;
+	m_queuedAngularImpulse[slot] = ZERO;
+
+	if (m_physicsFlight[slot])
+	{
+		m_physicsBatch.StepRange(frameTime, slot, slot + 1);
+		linearImpulse += ToVec3(m_physicsBatch.GetLinearImpulse(slot));
+		angularImpulse += ToVec3(m_physicsBatch.GetAngularImpulse(slot));
+	}
+
+	if (linearImpulse.IsZero() && angularImpulse.IsZero())
+		return;
+
+	// One action per ship per substep. Already on the physics thread, executed immediately instead of queued
+	pe_action_impulse actionImpulse;
+	actionImpulse.impulse = linearImpulse;
+	actionImpulse.angImpulse = angularImpulse;
+	pPhysicalEntity->Action(&actionImpulse, 1);
+}
+
+int CFlightSystem::OnPhysicsPostStep(const EventPhys* pEvent)
+{
+	const EventPhysPostStep* pPostStep = static_cast<const EventPhysPostStep*>(pEvent);
+	GetInstance().StepPhysicalEntity(pPostStep->pEntity, pPostStep->dt);
+	return 1;
+}
+
+float CFlightSystem::GetLevelTime() const
+{
+	return (gEnv->pTimer->GetFrameStartTime() - m_levelStartTime).GetSeconds();
+}
+
+void CFlightSystem::ResetLevelTime()
+{
+	m_levelStartTime = gEnv->pTimer->GetFrameStartTime();
+}
+
+void CFlightSystem::Shutdown()
+{
+	if (m_physicsStepActive)
+		SetPhysicsStepActive(false);
+}
+
+///////////////////////////////////////////////////////////////////////////
+// CONSOLE
+///////////////////////////////////////////////////////////////////////////
+void CFlightSystem::RegisterConsoleCommands()
+{
+	REGISTER_CVAR2("flight_fixedRate", &s_fixedRate, s_fixedRate, VF_REQUIRE_NET_SYNC, "Flight tick rate in Hz (e.g. 60, 120). 0 steps the flight once per frame, or at flight_netTickRate in a networked game");
+	REGISTER_CVAR2("flight_netTickRate", &s_netTickRate, s_netTickRate, VF_REQUIRE_NET_SYNC, "Flight tick rate in Hz of networked games when flight_fixedRate is 0. Every pilot input is one tick, on the client and on the server");
+	REGISTER_CVAR2("flight_maxCatchUpSteps", &s_maxCatchUpSteps, s_maxCatchUpSteps, VF_NULL, "Maximum fixed flight ticks run in a single frame, the remaining time is dropped");
+	REGISTER_CVAR2("flight_physicsStep", &s_physicsStep, s_physicsStep, VF_NULL, "1 integrates the jerk and applies the flight impulses on every physics substep (overrides flight_fixedRate). Single player only");
+	REGISTER_CVAR2("flight_inputSendRate", &s_inputSendRate, s_inputSendRate, VF_NULL, "Rate in Hz of the pilot input packets sent to the server, each carries the last few inputs. 0 sends one per flight step");
+	REGISTER_CVAR2("flight_snapshotRate", &s_snapshotRate, s_snapshotRate, VF_NULL, "Rate in Hz at which the server replicates ship states. 0 replicates every flight step");
+	REGISTER_CVAR2("flight_interpolationDelay", &s_interpolationDelay, s_interpolationDelay, VF_NULL, "Seconds remote ships are played back behind their newest snapshot. Should cover about two snapshot intervals");
+	REGISTER_CVAR2("flight_maxExtrapolation", &s_maxExtrapolation, s_maxExtrapolation, VF_NULL, "Seconds a remote ship keeps moving past its newest snapshot when the next one is late");
+}
+
+void CFlightSystem::UnregisterConsoleCommands()
+{
+	if (gEnv->pConsole)
+	{
+		gEnv->pConsole->UnregisterVariable("flight_fixedRate");
+		gEnv->pConsole->UnregisterVariable("flight_netTickRate");
+		gEnv->pConsole->UnregisterVariable("flight_maxCatchUpSteps");
+		gEnv->pConsole->UnregisterVariable("flight_physicsStep");
+		gEnv->pConsole->UnregisterVariable("flight_inputSendRate");
+		gEnv->pConsole->UnregisterVariable("flight_snapshotRate");
+		gEnv->pConsole->UnregisterVariable("flight_interpolationDelay");
+		gEnv->pConsole->UnregisterVariable("flight_maxExtrapolation");
+	}
+}
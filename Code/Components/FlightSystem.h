@@ -0,0 +1,145 @@
+// Copyright 2017-2021 Crytek GmbH / Crytek Group. All rights reserved.
+#pragma once
+#include <array>
+#include <vector>
+#include <CryThreading/CryThread.h>
+
+#include <Components/FlightBatch.h>
+
+class CFlightController;
+struct IPhysicalEntity;
+struct EventPhys;
+
+// Engine and flight model vectors
+inline SFlightVec3 ToFlightVec3(const Vec3& value) { return SFlightVec3(value.x, value.y, value.z); }
+inline Vec3 ToVec3(const SFlightVec3& value) { return Vec3(value.x, value.y, value.z); }
+
+////////////////////////////////////////////////////////
+// Steps the flight batch of every registered ship together and hands the impulses to the engine.
+// Flight controllers only register, publish their target accelerations and receive the resulting impulses.
+////////////////////////////////////////////////////////
+class CFlightSystem
+{
+public:
+	using SlotId = CFlightBatch::SlotId;
+	using EJerkGroup = ::EJerkGroup;
+	static constexpr SlotId kInvalidSlot = ~0u;
+
+	CFlightSystem() = default;
+	~CFlightSystem() = default;
+
+	static CFlightSystem& GetInstance()
+	{
+		static CFlightSystem instance;
+		return instance;
+	}
+
+	// Registration
+	SlotId RegisterShip(CFlightController* pController);
+	void UnregisterShip(SlotId slot);
+	size_t GetShipCount() const { return m_controllers.size() - m_freeSlots.size(); }
+	// Indexed by slot, free slots are null
+	const std::vector<CFlightController*>& GetControllers() const { return m_controllers; }
+
+	// Per ship parameters
+	void SetJerkRates(SlotId slot, EJerkGroup group, float jerk, float jerkDecelRate);
+	void ResetJerk(SlotId slot);
+	void SetImpulseScale(SlotId slot, float mass, float linearScale, float angularScale);
+
+	// Target accelerations and acceleration states of every group, from CFlightModel::ComputeTargets
+	void SetTargets(SlotId slot, const SFlightTargets& targets);
+
+	// Overrides the jerk-smoothed acceleration, used when a client is corrected by the server.
+	// In physics step mode the override reaches the physics thread with the next published targets.
+	void SetCurrentAccel(SlotId slot, EJerkGroup group, const Vec3& currentAccel);
+	Vec3 GetCurrentAccel(SlotId slot, EJerkGroup group) const;
+
+	// Copy of the jerk state of every group, safe to use for simulated (math only) calculations
+	std::array<JerkAccelerationData, (size_t)EJerkGroup::Count> GetJerkData(SlotId slot) const;
+
+	// Runs the flight ticks due this frame, at the frame rate or at the fixed rate (GetFixedRate)
+	void Update(float frameTime);
+
+	// Fixed flight tick in Hz, 0 ticks once per frame. Networked games always tick at a fixed rate (flight_netTickRate by default):
+	// a pilot input is one tick on the client and exactly one tick on the server.
+	static int GetFixedRate();
+	static bool IsNetworked();
+
+	// Rate in Hz at which pilots send their input packets, 0 sends one per flight step
+	static int GetInputSendRate() { return s_inputSendRate; }
+	// Rate in Hz at which the server replicates ship states, 0 replicates every flight step
+	static int GetSnapshotRate() { return s_snapshotRate; }
+	// Remote ship playback: delay behind the newest snapshot, and how long a late snapshot is extrapolated for (seconds)
+	static float GetInterpolationDelay() { return s_interpolationDelay; }
+	static float GetMaxExtrapolation() { return s_maxExtrapolation; }
+
+	// Physics step mode: a force held over every substep (anti-gravity), and impulses added to the next substep.
+	// Both go out in the substep's single action with the flight impulse.
+	bool IsPhysicsStepActive() const { return m_physicsStepActive; }
+	void SetHoldForce(SlotId slot, const Vec3& force);
+	void QueueImpulse(SlotId slot, const Vec3& linearImpulse, const Vec3& angularImpulse);
+
+	// Seconds since gameplay started in this level. Timestamps exchanged with the server (snapshots, shot view times) are on this timeline:
+	// unlike the engine's absolute time it keeps its float precision however long the process has been running.
+	float GetLevelTime() const;
+	void ResetLevelTime();
+
+	// Removes the physics listener, called on shutdown
+	void Shutdown();
+
+	static void RegisterConsoleCommands();
+	static void UnregisterConsoleCommands();
+
+private:
+	CFlightSystem(const CFlightSystem&) = delete;
+	CFlightSystem& operator=(const CFlightSystem&) = delete;
+
+	void Resize(size_t size);
+
+	// Gathers targets from every controller, steps all ships and hands the impulses back
+	void Tick(float frameTime);
+
+	// Physics step mode (flight_physicsStep): the main thread only publishes targets, integration and impulses run per physics substep
+	void SetPhysicsStepActive(bool active);
+	void UpdatePhysicsStep(float frameTime);
+	// Under m_physicsLock: the accelerations integrated by the physics thread back into m_batch, and the gathered inputs out to it
+	void SnapshotPhysicsBatch();
+	void PublishPhysicsBatch();
+	void StepPhysicalEntity(IPhysicalEntity* pPhysicalEntity, float frameTime);
+	static int OnPhysicsPostStep(const EventPhys* pEvent);
+
+	// Main thread batch: controllers write their targets to it and read the jerk state from it
+	CFlightBatch m_batch;
+	std::vector<uint8> m_active;
+	std::vector<uint8> m_accelOverridden; // Current accelerations set on the main thread, not yet published
+
+	std::vector<CFlightController*> m_controllers;
+	std::vector<SlotId> m_freeSlots;
+
+	// Time not yet consumed by fixed ticks
+	float m_accumulator = 0.f;
+	bool m_wasFixedRate = false;
+	CTimeValue m_levelStartTime;
+	bool m_ticksAwaitingPose = false; // Fixed ticks ran, their pose is recorded once physics has stepped them
+
+	// Physics step mode, the lock guards the physics batch and the slot arrays against the physics thread
+	bool m_physicsStepActive = false;
+	CFlightBatch m_physicsBatch;
+	std::vector<uint8> m_physicsDriven;
+	std::vector<uint8> m_physicsFlight; // The flight impulse is applied, not only the held force and queued impulses
+	std::vector<Vec3> m_holdForce;
+	std::vector<Vec3> m_queuedLinearImpulse;
+	std::vector<Vec3> m_queuedAngularImpulse;
+	VectorMap<IPhysicalEntity*, SlotId> m_physicsSlots;
+	CryCriticalSection m_physicsLock;
+
+	// CVars
+	static int s_fixedRate;
+	static int s_netTickRate;
+	static int s_maxCatchUpSteps;
+	static int s_physicsStep;
+	static int s_inputSendRate;
+	static int s_snapshotRate;
+	static float s_interpolationDelay;
+	static float s_maxExtrapolation;
+};
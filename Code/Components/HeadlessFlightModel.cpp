@@ -0,0 +1,149 @@
+// Copyright 2017-2019 Crytek GmbH / Crytek Group. All rights reserved.
+#include "HeadlessFlightModel.h"
+
+SFlightVec3 SFlightQuat::operator*(const SFlightVec3& value) const
+{
+	// v + 2w (q x v) + 2 q x (q x v)
+	const SFlightVec3 q(x, y, z);
+	const SFlightVec3 t(2.f * (q.y * value.z - q.z * value.y), 2.f * (q.z * value.x - q.x * value.z), 2.f * (q.x * value.y - q.y * value.x));
+	return value + t * w + SFlightVec3(q.y * t.z - q.z * t.y, q.z * t.x - q.x * t.z, q.x * t.y - q.y * t.x);
+}
+
+void SFlightQuat::Integrate(const SFlightVec3& angularVelocity, float frameTime)
+{
+	const float angularSpeed = angularVelocity.GetLength();
+	if (angularSpeed <= 0.f)
+		return;
+
+	const float halfAngle = 0.5f * angularSpeed * frameTime;
+	const float s = std::sin(halfAngle) / angularSpeed;
+	const float dw = std::cos(halfAngle);
+	const float dx = angularVelocity.x * s;
+	const float dy = angularVelocity.y * s;
+	const float dz = angularVelocity.z * s;
+
+	// World space rotation, applied on the left
+	const SFlightQuat rotated = { dw * w - dx * x - dy * y - dz * z, dw * x + dx * w + dy * z - dz * y, dw * y - dx * z + dy * w + dz * x, dw * z + dx * y - dy * x + dz * w };
+	const float length = std::sqrt(rotated.w * rotated.w + rotated.x * rotated.x + rotated.y * rotated.y + rotated.z * rotated.z);
+	w = rotated.w / length;
+	x = rotated.x / length;
+	y = rotated.y / length;
+	z = rotated.z / length;
+}
+
+CHeadlessFlightModel::CHeadlessFlightModel(const SFlightProfile& profile, float mass, const SFlightVec3& gravity)
+	: m_profile(profile)
+	, m_mass(mass)
+	, m_gravity(gravity)
+{
+}
+
+SFlightProfile CHeadlessFlightModel::GetReferenceProfile()
+{
+	const float degToRad = 3.14159265f / 180.f;
+	const auto axis = [](EJerkGroup group, float accel, float velocityLimit, const SFlightVec3& localDirection)
+	{
+		SFlightAxis result;
+		result.group = group;
+		result.accel = accel;
+		result.velocityLimit = velocityLimit;
+		result.localDirection = localDirection;
+		return result;
+	};
+
+	SFlightProfile profile;
+	profile.axes[(size_t)EShipAxis::AccelForward] = axis(EJerkGroup::Linear, 30.f, 150.f, SFlightVec3(0.f, 1.f, 0.f));
+	profile.axes[(size_t)EShipAxis::AccelBackward] = axis(EJerkGroup::Linear, 20.f, 60.f, SFlightVec3(0.f, -1.f, 0.f));
+	profile.axes[(size_t)EShipAxis::AccelLeft] = axis(EJerkGroup::Linear, 15.f, 50.f, SFlightVec3(-1.f, 0.f, 0.f));
+	profile.axes[(size_t)EShipAxis::AccelRight] = axis(EJerkGroup::Linear, 15.f, 50.f, SFlightVec3(1.f, 0.f, 0.f));
+	profile.axes[(size_t)EShipAxis::AccelUp] = axis(EJerkGroup::Linear, 15.f, 50.f, SFlightVec3(0.f, 0.f, 1.f));
+	profile.axes[(size_t)EShipAxis::AccelDown] = axis(EJerkGroup::Linear, 15.f, 50.f, SFlightVec3(0.f, 0.f, -1.f));
+	profile.axes[(size_t)EShipAxis::RollLeft] = axis(EJerkGroup::Roll, 90.f * degToRad, 120.f * degToRad, SFlightVec3(0.f, -1.f, 0.f));
+	profile.axes[(size_t)EShipAxis::RollRight] = axis(EJerkGroup::Roll, 90.f * degToRad, 120.f * degToRad, SFlightVec3(0.f, 1.f, 0.f));
+	profile.axes[(size_t)EShipAxis::Yaw] = axis(EJerkGroup::PitchYaw, 60.f * degToRad, 90.f * degToRad, SFlightVec3(0.f, 0.f, -1.f));
+	profile.axes[(size_t)EShipAxis::Pitch] = axis(EJerkGroup::PitchYaw, 60.f * degToRad, 90.f * degToRad, SFlightVec3(-1.f, 0.f, 0.f));
+
+	profile.jerk = { 2.f, 3.f, 3.f };
+	profile.jerkDecelRate = { 4.f, 6.f, 6.f };
+	profile.linearBoost = 2.f;
+	profile.angularBoost = 2.f;
+	profile.logBase = 2.f;
+	profile.logMaxDiscrepancy = 50.f;
+	return profile;
+}
+
+size_t CHeadlessFlightModel::AddShip(const SBody& body)
+{
+	const CFlightBatch::SlotId slot = (CFlightBatch::SlotId)m_bodies.size();
+	m_batch.Resize(slot + 1);
+	m_batch.SetImpulseScale(slot, m_mass, 1.f, 1.f);
+	for (size_t group = 0; group < (size_t)EJerkGroup::Count; ++group)
+		m_batch.SetJerkRates(slot, (EJerkGroup)group, m_profile.jerk[group], m_profile.jerkDecelRate[group]);
+
+	m_bodies.push_back(body);
+	m_inputs.emplace_back();
+	m_motions.emplace_back();
+	m_modifiers.emplace_back();
+	return slot;
+}
+
+void CHeadlessFlightModel::SetJerkState(size_t ship, const std::array<JerkAccelerationData, (size_t)EJerkGroup::Count>& jerkData)
+{
+	const CFlightBatch::SlotId slot = (CFlightBatch::SlotId)ship;
+	for (size_t group = 0; group < (size_t)EJerkGroup::Count; ++group)
+	{
+		m_batch.SetCurrentAccel(slot, (EJerkGroup)group, jerkData[group].currentJerkAccel);
+		m_batch.SetTargetAccel(slot, (EJerkGroup)group, jerkData[group].targetJerkAccel, jerkData[group].state);
+	}
+}
+
+void CHeadlessFlightModel::Gather(size_t ship, float frameTime)
+{
+	const SBody& body = m_bodies[ship];
+	const SShipInputSnapshot& input = m_inputs[ship];
+	const CFlightBatch::SlotId slot = (CFlightBatch::SlotId)ship;
+
+	// CFlightController::UpdateKinematics
+	SFlightMotion& motion = m_motions[ship];
+	motion.velocity = body.velocity;
+	motion.angularVelocity = body.angularVelocity;
+	motion.mass = m_mass;
+	for (size_t axis = 0; axis < (size_t)EShipAxis::Count; ++axis)
+		motion.thrusterDirections[axis] = body.orientation * m_profile.axes[axis].localDirection;
+
+	// CFlightController::FlightModifierHandler
+	FlightModifierBitFlag& modifiers = m_modifiers[ship];
+	modifiers = input.modifiers;
+	CFlightModel::ResolveModifiers(modifiers);
+
+	const SFlightTargets targets = CFlightModel::ComputeTargets(m_profile, motion, input, m_batch.GetJerkData(slot), frameTime);
+	for (size_t group = 0; group < (size_t)EJerkGroup::Count; ++group)
+		m_batch.SetTargetAccel(slot, (EJerkGroup)group, targets.accel[group], targets.state[group]);
+
+	m_batch.SetImpulseScale(slot, m_mass, CFlightModel::GetLinearScale(m_profile, modifiers), CFlightModel::GetAngularScale(m_profile, modifiers));
+}
+
+void CHeadlessFlightModel::Step(float frameTime)
+{
+	const size_t count = m_bodies.size();
+
+	for (size_t i = 0; i < count; ++i)
+		Gather(i, frameTime);
+
+	m_batch.Step(frameTime);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		SBody& body = m_bodies[i];
+
+		// CFlightController::CommitFlightStep, without thrusters the impulse is applied as is
+		SFlightVec3 linearImpulse = m_batch.GetLinearImpulse((CFlightBatch::SlotId)i);
+		if (m_modifiers[i].HasFlag(EFlightModifierFlag::Gravity))
+			linearImpulse += CFlightModel::GetAntiGravityForce(m_profile, m_motions[i], m_gravity) * frameTime;
+
+		body.velocity += linearImpulse / m_mass + m_gravity * frameTime;
+		body.angularVelocity += m_batch.GetAngularImpulse((CFlightBatch::SlotId)i) / m_mass;
+		body.position += body.velocity * frameTime;
+		body.orientation.Integrate(body.angularVelocity, frameTime);
+	}
+}
@@ -0,0 +1,68 @@
+// Copyright 2017-2021 Crytek GmbH / Crytek Group. All rights reserved.
+#pragma once
+#include <vector>
+
+#include <Components/FlightBatch.h>
+
+// Orientation of the mock body, only what the headless model needs
+struct SFlightQuat
+{
+	float w = 1.f;
+	float x = 0.f;
+	float y = 0.f;
+	float z = 0.f;
+
+	// Rotates a vector
+	SFlightVec3 operator*(const SFlightVec3& value) const;
+	// Turns by a world space angular velocity over frameTime
+	void Integrate(const SFlightVec3& angularVelocity, float frameTime);
+};
+
+////////////////////////////////////////////////////////
+// Flight model without entity or physics: a mock rigid body per ship, stepped through the same gather as
+// CFlightController::PrepareFlightStep (CFlightModel) and its own CFlightBatch. Used by the benchmark and the replayer.
+////////////////////////////////////////////////////////
+class CHeadlessFlightModel
+{
+public:
+	// Stand-in for the rigid body, integrates gravity and the impulses the flight batch hands back
+	struct SBody
+	{
+		SFlightVec3 position;
+		SFlightVec3 velocity;
+		SFlightVec3 angularVelocity;
+		SFlightQuat orientation;
+	};
+
+	// Every ship flies the same profile with the same mass, there are no thrusters to allocate to
+	CHeadlessFlightModel(const SFlightProfile& profile, float mass, const SFlightVec3& gravity);
+
+	// Fixed ship of the benchmark, laid out like CFlightController::InitializeMotionParamsVectors
+	static SFlightProfile GetReferenceProfile();
+	static constexpr float kReferenceMass = 1000.f;
+
+	size_t AddShip(const SBody& body = SBody());
+	// Starts a ship mid flight, e.g. from a recording. The jerk rates stay those of the profile.
+	void SetJerkState(size_t ship, const std::array<JerkAccelerationData, (size_t)EJerkGroup::Count>& jerkData);
+	size_t GetShipCount() const { return m_bodies.size(); }
+	const SBody& GetBody(size_t ship) const { return m_bodies[ship]; }
+
+	// Input used by the next step. Modifiers pick the mode as in the game (Coupled, Boost, Gravity).
+	void SetInput(size_t ship, const SShipInputSnapshot& input) { m_inputs[ship] = input; }
+
+	// Gathers every ship from its input, steps the flight batch and integrates the bodies
+	void Step(float frameTime);
+
+private:
+	void Gather(size_t ship, float frameTime);
+
+	SFlightProfile m_profile;
+	float m_mass;
+	SFlightVec3 m_gravity;
+
+	CFlightBatch m_batch;
+	std::vector<SBody> m_bodies;
+	std::vector<SShipInputSnapshot> m_inputs;
+	std::vector<SFlightMotion> m_motions;
+	std::vector<FlightModifierBitFlag> m_modifiers; // Resolved by the gather
+};
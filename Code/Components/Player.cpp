@@ -1,10 +1,12 @@
 // Copyright 2017-2020 Crytek GmbH / Crytek Group. All rights reserved.
 #include "StdAfx.h"
 #include "Player.h"
-#include "Bullet.h"
+#include "BallisticsSystem.h"
 #include "SpawnPoint.h"
 #include "GamePlugin.h"
 
+#include <algorithm>
+
 #include <CryRenderer/IRenderAuxGeom.h>
 #include <CrySchematyc/Env/Elements/EnvComponent.h>
 #include <CryCore/StaticInstanceList.h>
@@ -14,6 +16,12 @@
 
 #include <Components/VehicleComponent.h>
 #include <Components/FlightModifiers.h>
+#include <Components/FlightController.h>
+#include <Components/FlightSystem.h>
+#include <Components/RayCastService.h>
+#include <Components/ShipReplication.h>
+#include <Components/TransformHistory.h>
+#include <Components/VehicleIndex.h>
 
 // Forward declaration
 #include <DefaultComponents/Cameras/CameraComponent.h>
@@ -27,6 +35,11 @@
 
 namespace
 {
+	// Shots starting further than this from the shooter are rejected
+	constexpr float kMaxShotOriginError = 5.f;
+	// Rounds a shooter may bank on the server, in seconds of fire: covers send intervals and packets bunched by jitter
+	constexpr float kMaxFireBacklog = 0.5f;
+
 	static void RegisterPlayerComponent(Schematyc::IEnvRegistrar& registrar)
 	{
 		Schematyc::CEnvRegistrationScope scope = registrar.Scope(IEntity::GetEntityScopeGUID());
@@ -75,7 +88,7 @@ void CPlayerComponent::Initialize()
 
 	// Do so for the other relevant functions as well 
 	SRmi<RMI_WRAP(&CPlayerComponent::ServerRequestFire)>::Register(this, eRAT_NoAttach, false, eNRT_ReliableOrdered);
-	SRmi<RMI_WRAP(&CPlayerComponent::ClientFire)>::Register(this, eRAT_NoAttach, false, eNRT_ReliableOrdered);
+	SRmi<RMI_WRAP(&CPlayerComponent::ClientReceiveFireEvents)>::Register(this, eRAT_NoAttach, false, eNRT_ReliableOrdered);
 
 	SRmi<RMI_WRAP(&CPlayerComponent::ServerEnterVehicle)>::Register(this, eRAT_NoAttach, false, eNRT_ReliableOrdered);
 	SRmi<RMI_WRAP(&CPlayerComponent::ClientEnterVehicle)>::Register(this, eRAT_NoAttach, false, eNRT_ReliableOrdered);
@@ -85,6 +98,9 @@ void CPlayerComponent::Initialize()
 
 	SRmi<RMI_WRAP(&CPlayerComponent::ServerUpdatePlayerPosition)>::Register(this, eRAT_NoAttach, false, eNRT_ReliableOrdered); 
 	SRmi<RMI_WRAP(&CPlayerComponent::ClientApplyNewPosition)>::Register(this, eRAT_NoAttach, false, eNRT_ReliableOrdered);
+
+	// Ship states, a newer snapshot replaces a lost one
+	SRmi<RMI_WRAP(&CPlayerComponent::ClientReceiveShipSnapshot)>::Register(this, eRAT_NoAttach, false, eNRT_UnreliableUnordered);
 }
 
 void CPlayerComponent::InitializeLocalPlayer()
@@ -135,13 +151,21 @@ void CPlayerComponent::ProcessEvent(const SEntityEvent& event)
 			{
 				if (m_pCameraComponent)
 					UpdateCamera(frameTime);
+
+				UpdateInteractionPrompt();
 			}
 		}
 		else
 		{
 			m_position = GetEntity()->GetWorldPos();
 			m_rotation = GetEntity()->GetWorldRotation();
+
+			if (IsLocalClient())
+				PublishShipInput();
 		}
+
+		if (IsLocalClient())
+			UpdateFire(frameTime);
 	}
 	break;
 	case Cry::Entity::EEvent::Hidden:
@@ -162,6 +186,9 @@ void CPlayerComponent::ProcessEvent(const SEntityEvent& event)
 		gEnv->pConsole->GetCVar("is_piloting")->Set(false);
 		// Disable player when leaving game mode.
 		m_isAlive = event.nParam[0] != 0;
+		// CRayCastService drops its rays with the level, the answer may never come
+		m_visibleVehicleId = INVALID_ENTITYID;
+		m_isLineOfSightPending = false;
 	}
 	break;
 	}
@@ -212,10 +239,16 @@ void CPlayerComponent::InitializePilotInput()
 	// Register the shoot action
 	m_pInputComponent->RegisterAction("pilot", "shoot", [this](int activationMode, float value)
 		{
-			// Only fire on press, not release
+			// A round on press, then automatic fire until release (UpdateFire)
 			if (activationMode & eAAM_OnPress && !GetIsPiloting())
 			{
-				SRmi<RMI_WRAP(&CPlayerComponent::ServerRequestFire)>::InvokeOnServer(this, NoParams{});
+				m_isTriggerHeld = true;
+				m_fireTimer = 1.f / m_fireRate;
+				Fire(1);
+			}
+			else if (activationMode & eAAM_OnRelease)
+			{
+				m_isTriggerHeld = false;
 			}
 		});
 
@@ -226,36 +259,36 @@ void CPlayerComponent::InitializePilotInput()
 void CPlayerComponent::InitializeShipInput()
 {
 	// Translation Controls
-	m_pInputComponent->RegisterAction("ship", "accel_forward", [this](int activationMode, float value) { m_axisValues["accel_forward"] = value; });
+	m_pInputComponent->RegisterAction("ship", "accel_forward", [this](int activationMode, float value) { m_pendingShipInput.SetAxis(EShipAxis::AccelForward, value); });
 	m_pInputComponent->BindAction("ship", "accel_forward", eAID_KeyboardMouse, eKI_W);
 
-	m_pInputComponent->RegisterAction("ship", "accel_backward", [this](int activationMode, float value) {m_axisValues["accel_backward"] = value;});
+	m_pInputComponent->RegisterAction("ship", "accel_backward", [this](int activationMode, float value) {m_pendingShipInput.SetAxis(EShipAxis::AccelBackward, value);});
 	m_pInputComponent->BindAction("ship", "accel_backward", eAID_KeyboardMouse, eKI_S);
 
-	m_pInputComponent->RegisterAction("ship", "accel_right", [this](int activationMode, float value) {m_axisValues["accel_right"] = value;});
+	m_pInputComponent->RegisterAction("ship", "accel_right", [this](int activationMode, float value) {m_pendingShipInput.SetAxis(EShipAxis::AccelRight, value);});
 	m_pInputComponent->BindAction("ship", "accel_right", eAID_KeyboardMouse, eKI_D);
 
-	m_pInputComponent->RegisterAction("ship", "accel_left", [this](int activationMode, float value) {m_axisValues["accel_left"] = value;});
+	m_pInputComponent->RegisterAction("ship", "accel_left", [this](int activationMode, float value) {m_pendingShipInput.SetAxis(EShipAxis::AccelLeft, value);});
 	m_pInputComponent->BindAction("ship", "accel_left", eAID_KeyboardMouse, eKI_A);
 
-	m_pInputComponent->RegisterAction("ship", "accel_up", [this](int activationMode, float value) {m_axisValues["accel_up"] = value;});
+	m_pInputComponent->RegisterAction("ship", "accel_up", [this](int activationMode, float value) {m_pendingShipInput.SetAxis(EShipAxis::AccelUp, value);});
 	m_pInputComponent->BindAction("ship", "accel_up", eAID_KeyboardMouse, eKI_Space);
 
-	m_pInputComponent->RegisterAction("ship", "accel_down", [this](int activationMode, float value) {m_axisValues["accel_down"] = value;});
+	m_pInputComponent->RegisterAction("ship", "accel_down", [this](int activationMode, float value) {m_pendingShipInput.SetAxis(EShipAxis::AccelDown, value);});
 	m_pInputComponent->BindAction("ship", "accel_down", eAID_KeyboardMouse, eKI_LCtrl);
 
 	// Rotation Controls
 
-	m_pInputComponent->RegisterAction("ship", "yaw", [this](int activationMode, float value) {m_axisValues["pitch"] = value; });
+	m_pInputComponent->RegisterAction("ship", "yaw", [this](int activationMode, float value) {m_pendingShipInput.SetAxis(EShipAxis::Pitch, value); });
 	m_pInputComponent->BindAction("ship", "yaw", eAID_KeyboardMouse, eKI_MouseY);
 
-	m_pInputComponent->RegisterAction("ship", "pitch", [this](int activationMode, float value) {m_axisValues["yaw"] = value; });
+	m_pInputComponent->RegisterAction("ship", "pitch", [this](int activationMode, float value) {m_pendingShipInput.SetAxis(EShipAxis::Yaw, value); });
 	m_pInputComponent->BindAction("ship", "pitch", eAID_KeyboardMouse, eKI_MouseX);
 
-	m_pInputComponent->RegisterAction("ship", "roll_left", [this](int activationMode, float value) {m_axisValues["roll_left"] = value; });
+	m_pInputComponent->RegisterAction("ship", "roll_left", [this](int activationMode, float value) {m_pendingShipInput.SetAxis(EShipAxis::RollLeft, value); });
 	m_pInputComponent->BindAction("ship", "roll_left", eAID_KeyboardMouse, eKI_Q);
 
-	m_pInputComponent->RegisterAction("ship", "roll_right", [this](int activationMode, float value) {m_axisValues["roll_right"] = value; });
+	m_pInputComponent->RegisterAction("ship", "roll_right", [this](int activationMode, float value) {m_pendingShipInput.SetAxis(EShipAxis::RollRight, value); });
 	m_pInputComponent->BindAction("ship", "roll_right", eAID_KeyboardMouse, eKI_E);
 
 	// Actions
@@ -312,40 +345,98 @@ void CPlayerComponent::Interact(int activationMode)
 {
 	if (activationMode == (int)eAAM_OnPress)
 	{
-		// Creating an offset due to the camera position being set in code. Otherwise, the raycast would be stuck into the ground.
-		Vec3 offsetWorldPos = Vec3(m_pCameraComponent->GetEntity()->GetWorldPos().x, m_pCameraComponent->GetEntity()->GetWorldPos().y, m_pCameraComponent->GetEntity()->GetWorldPos().z + m_cameraDefaultPos.z);
-		IEntity* pHitEntity = RayCast(offsetWorldPos, m_lookOrientation, *m_pEntity);
-		if (pHitEntity && pHitEntity->GetComponent<CVehicleComponent>())
-		{
-			bool hasPlayerComponent = false;
+		IEntity* pVehicleEntity = FindBoardableVehicle();
+		if (pVehicleEntity && pVehicleEntity->GetId() == m_visibleVehicleId)
+			BoardVehicle(*pVehicleEntity);
+	}
+}
 
-			// Check if the child entity has a CPlayerComponent
-			for (uint32 i = 0; i < pHitEntity->GetChildCount(); ++i)
-			{
-				IEntity* pChildEntity = pHitEntity->GetChild(i);
-				if (pChildEntity && pChildEntity->GetComponent<CPlayerComponent>())
-				{
-					hasPlayerComponent = true;
-					break;
-				}
-			}
-			if (!hasPlayerComponent)
-			{
-				SRmi<RMI_WRAP(&CPlayerComponent::ServerEnterVehicle)>::InvokeOnServer(this, SerializeVehicleSwitchData{ GetEntity()->GetName(), GetEntity()->GetId() , pHitEntity->GetName(), pHitEntity->GetId()});
-				pHitEntity->GetComponent<Cry::DefaultComponents::CCameraComponent>()->Activate(); // Activate the target's camera to switch view points
-			}
-		}
+Vec3 CPlayerComponent::GetEyePosition() const
+{
+	// Creating an offset due to the camera position being set in code, the view starts at the eyes
+	return m_pCameraComponent->GetEntity()->GetWorldPos() + Vec3(0.f, 0.f, m_cameraDefaultPos.z);
+}
+
+IEntity* CPlayerComponent::FindBoardableVehicle() const
+{
+	const Vec3 viewDirection = m_lookOrientation.GetColumn1().GetNormalized();
+
+	return CVehicleIndex::GetInstance().FindBoardable(GetEyePosition(), viewDirection, m_playerInteractionRange, m_interactionConeCos);
+}
+
+void CPlayerComponent::CheckLineOfSight(const IEntity& vehicleEntity)
+{
+	AABB worldBounds;
+	vehicleEntity.GetWorldBounds(worldBounds);
+
+	const Vec3 eyePosition = GetEyePosition();
+	const EntityId playerId = GetEntityId();
+	const EntityId vehicleId = vehicleEntity.GetId();
+	m_isLineOfSightPending = true;
+
+	// Aimed at the center of the vehicle, anything else hit first blocks the view
+	CRayCastService::GetInstance().Submit(eyePosition, worldBounds.GetCenter() - eyePosition, playerId, [playerId, vehicleId](const CRayCastService::SResult& result)
+	{
+		// The player may have left while the ray was in flight
+		IEntity* pPlayerEntity = gEnv->pEntitySystem->GetEntity(playerId);
+		CPlayerComponent* pPlayer = pPlayerEntity ? pPlayerEntity->GetComponent<CPlayerComponent>() : nullptr;
+		if (!pPlayer)
+			return;
+
+		const bool isVisible = !result.isHit || (result.pEntity && result.pEntity->GetId() == vehicleId);
+		pPlayer->m_visibleVehicleId = isVisible ? vehicleId : INVALID_ENTITYID;
+		pPlayer->m_isLineOfSightPending = false;
+	});
+}
+
+void CPlayerComponent::UpdateInteractionPrompt()
+{
+	// The grid narrows it down to the vehicle in view, the ray only checks that one
+	const IEntity* pVehicleEntity = FindBoardableVehicle();
+	if (!pVehicleEntity)
+	{
+		m_visibleVehicleId = INVALID_ENTITYID;
+		return;
+	}
+
+	if (!m_isLineOfSightPending)
+		CheckLineOfSight(*pVehicleEntity);
+
+	if (pVehicleEntity->GetId() == m_visibleVehicleId)
+	{
+		gEnv->pAuxGeomRenderer->Draw2dLabel(50, 210, 2, ColorF(1, 1, 1, 1), false, "(F) Board %s", pVehicleEntity->GetName());
 	}
 }
 
-FlightModifierBitFlag CPlayerComponent::GetFlightModifierState() const
+void CPlayerComponent::BoardVehicle(IEntity& vehicleEntity)
 {
-	return m_FlightModifierFlag;
+	if (vehicleEntity.GetComponent<CVehicleComponent>())
+	{
+		bool hasPlayerComponent = false;
+
+		// Check if the child entity has a CPlayerComponent
+		for (uint32 i = 0; i < vehicleEntity.GetChildCount(); ++i)
+		{
+			IEntity* pChildEntity = vehicleEntity.GetChild(i);
+			if (pChildEntity && pChildEntity->GetComponent<CPlayerComponent>())
+			{
+				hasPlayerComponent = true;
+				break;
+			}
+		}
+		if (!hasPlayerComponent)
+		{
+			SRmi<RMI_WRAP(&CPlayerComponent::ServerEnterVehicle)>::InvokeOnServer(this, SerializeVehicleSwitchData{ GetEntity()->GetName(), GetEntity()->GetId() , vehicleEntity.GetName(), vehicleEntity.GetId()});
+			vehicleEntity.GetComponent<Cry::DefaultComponents::CCameraComponent>()->Activate(); // Activate the target's camera to switch view points
+			m_visibleVehicleId = INVALID_ENTITYID;
+		}
+	}
 }
 
-float CPlayerComponent::GetAxisValue(const string& axisName)
+void CPlayerComponent::PublishShipInput()
 {
-	return m_axisValues[axisName];
+	m_pendingShipInput.modifiers = m_FlightModifierFlag;
+	m_shipInput = m_pendingShipInput;
 }
 
 void CPlayerComponent::UpdatePlayerMovementRequest(float frameTime)
@@ -496,40 +587,6 @@ void CPlayerComponent::UpdateAnimation(float frameTime)
 	GetEntity()->SetPosRotScale(GetEntity()->GetWorldPos(), correctedOrientation, Vec3(1, 1, 1));
 }
 
-IEntity* CPlayerComponent::RayCast(Vec3 origin, Quat dir, IEntity& pSkipSelf) const
-{
-	float m_debugColor[4] = { 1, 0, 0, 1 };
-	ray_hit hit;
-
-	// Convert quaternion to direction vector
-	Vec3 direction = dir.GetColumn1().GetNormalized(); // Assuming forward direction along y-axis
-	Vec3 finalDir = direction * m_playerInteractionRange;
-
-	int objTypes = ent_all;
-	const unsigned int flags = rwi_stop_at_pierceable | rwi_colltype_any;
-
-	// Initialize the skip entities array and assign the skip entity
-	IPhysicalEntity* pSkipEntities[1] = { pSkipSelf.GetPhysics() };
-
-	// Perform the ray world intersection
-	int hits = gEnv->pPhysicalWorld->RayWorldIntersection(origin, finalDir, objTypes, flags, &hit, 1, pSkipEntities, 1);
-
-	if (hits == 0 || !hit.pCollider) // Stop executing right here if there are no hits
-	{
-		return nullptr;
-	}
-
-	// Debug visualization (ensure this is disabled in production builds)
-	IPersistantDebug* pPD = gEnv->pGameFramework->GetIPersistantDebug();
-	pPD->Begin("Raycast", false);
-	pPD->AddSphere(hit.pt, 0.25f, ColorF(Vec3(1, 1, 0), 0.5f), 1.0f);
-
-
-	IEntity* pEntity = gEnv->pEntitySystem->GetEntityFromPhysics(hit.pCollider);
-
-	return pEntity;
-}
-
 bool CPlayerComponent::GetIsPiloting()
 {
 	if (!m_pEntity || !m_pEntity->GetParent())
@@ -676,42 +733,169 @@ bool CPlayerComponent::NetSerialize(TSerialize ser, EEntityAspects aspect, uint8
 	return true;
 }
 
-bool CPlayerComponent::ServerRequestFire(NoParams&& p, INetChannel*)
+bool CPlayerComponent::GetBarrelTransform(QuatT& transform) const
 {
-	SRmi<RMI_WRAP(&CPlayerComponent::ClientFire)>::InvokeOnAllClients(this, NoParams{});
-	return true;
+	if (ICharacterInstance* pCharacter = m_pAdvancedAnimationComponent->GetCharacter())
+	{
+		if (IAttachment* pBarrelOutAttachment = pCharacter->GetIAttachmentManager()->GetInterfaceByName("barrel_out"))
+		{
+			const QuatTS barrel = pBarrelOutAttachment->GetAttWorldAbsolute();
+			transform = QuatT(barrel.q, barrel.t);
+			return true;
+		}
+	}
+	return false;
 }
 
-bool CPlayerComponent::ClientFire(NoParams&& p, INetChannel*)
+void CPlayerComponent::Fire(uint8 burstCount)
 {
-	if (ICharacterInstance* pCharacter = m_pAdvancedAnimationComponent->GetCharacter())
-	{
-		IAttachment* pBarrelOutAttachment = pCharacter->GetIAttachmentManager()->GetInterfaceByName("barrel_out");
+	QuatT barrel;
+	if (!GetBarrelTransform(barrel))
+		return;
+
+	// The server checks the shot against what this client was showing when it fired
+	SFireEvent event;
+	event.viewTime = CShipReplication::GetInstance().GetEstimatedServerTime();
+	event.origin = barrel.t;
+	event.direction = barrel.q.GetColumn1();
+	event.seed = GetEntityId() * 2654435761u + m_fireSeed++;
+	event.burstCount = burstCount;
+	event.weapon = m_weaponType;
+
+	// No wait for the server, the rounds of the other peers come from the same seed
+	CBallisticsSystem::GetInstance().FireBurst(event.origin, event.direction, event.seed, event.burstCount, event.weapon, GetEntityId());
+
+	// Full before its tick, sent early
+	if (m_fireBatch.count == SFireBatch::kMaxEvents)
+		SendFireBatch();
+
+	m_fireBatch.events[m_fireBatch.count++] = event;
+}
+
+void CPlayerComponent::SendFireBatch()
+{
+	m_fireBatch.interpolationDelay = CFlightSystem::GetInterpolationDelay();
+
+	SRmi<RMI_WRAP(&CPlayerComponent::ServerRequestFire)>::InvokeOnServer(this, std::move(m_fireBatch));
+	m_fireBatch = SFireBatch();
+}
 
-		if (pBarrelOutAttachment != nullptr)
+void CPlayerComponent::UpdateFire(float frameTime)
+{
+	if (m_isTriggerHeld && !GetIsPiloting())
+	{
+		// Rounds due this frame leave together, one event
+		uint8 burstCount = 0;
+		m_fireTimer -= frameTime;
+		while (m_fireTimer <= 0.f && burstCount < SFireEvent::kMaxBurst)
 		{
-			QuatTS bulletOrigin = pBarrelOutAttachment->GetAttWorldAbsolute();
+			m_fireTimer += 1.f / m_fireRate;
+			++burstCount;
+		}
+		m_fireTimer = std::max(m_fireTimer, 0.f);
 
-			SEntitySpawnParams spawnParams;
-			spawnParams.pClass = gEnv->pEntitySystem->GetClassRegistry()->GetDefaultClass();
+		if (burstCount > 0)
+			Fire(burstCount);
+	}
 
-			spawnParams.vPosition = bulletOrigin.t;
-			spawnParams.qRotation = bulletOrigin.q;
+	// Sent at the input rate, 0 sends every frame
+	const int sendRate = CFlightSystem::GetInputSendRate();
+	m_fireSendTimer -= frameTime;
+	if (m_fireBatch.count == 0 || (sendRate > 0 && m_fireSendTimer > 0.f))
+		return;
 
-			const float bulletScale = 0.05f;
-			spawnParams.vScale = Vec3(bulletScale);
+	m_fireSendTimer = sendRate > 0 ? std::max(m_fireSendTimer + 1.f / (float)sendRate, 0.f) : 0.f;
+	SendFireBatch();
+}
 
-			// Spawn the entity
-			if (IEntity* pEntity = gEnv->pEntitySystem->SpawnEntity(spawnParams))
-			{
-				// See Bullet.cpp, bullet is propelled in  the rotation and position the entity was spawned with
-				pEntity->CreateComponentClass<CBulletComponent>();
-			}
+bool CPlayerComponent::ValidateShot(const SFireEvent& event, float interpolationDelay, SShotHits& outHits) const
+{
+	outHits.count = 0;
+
+	// Lag compensation: the targets are rewound to the shooter's view time, the shot only has to start near the shooter
+	const float originError = event.origin.GetDistance(m_pEntity->GetWorldPos());
+	if (originError > kMaxShotOriginError)
+	{
+		if (CTransformHistory::IsDebugEnabled())
+			CryLogAlways("[LagComp] %s rejected, shot starts %.1f m away", m_pEntity->GetName(), originError);
+		return false;
+	}
+
+	const CTransformHistory::SViewTime viewTime{ event.viewTime, interpolationDelay };
+	const float range = CBallisticsSystem::GetWeaponBallistics(event.weapon).maxRange;
+	for (uint8 round = 0; round < event.burstCount; ++round)
+	{
+		const Vec3 direction = CBallisticsSystem::GetRoundDirection(event.direction, event.seed, round);
+
+		CTransformHistory::SHit hit;
+		const bool isHit = CTransformHistory::GetInstance().RayCast(event.origin, direction, range, viewTime, GetEntityId(), hit);
+		if (isHit)
+			outHits.hits[outHits.count++] = hit;
+
+		if (CTransformHistory::IsDebugEnabled())
+		{
+			const float rewind = event.viewTime > 0.f ? CFlightSystem::GetInstance().GetLevelTime() - event.viewTime : 0.f;
+			if (isHit)
+				CryLogAlways("[LagComp] %s hit entity %u at %.1f m (rewind %.3f s)", m_pEntity->GetName(), hit.entityId, hit.distance, rewind);
+			else
+				CryLogAlways("[LagComp] %s missed (rewind %.3f s)", m_pEntity->GetName(), rewind);
 		}
 	}
 	return true;
 }
 
+bool CPlayerComponent::ServerRequestFire(SFireBatch&& batch, INetChannel*)
+{
+	const int channelId = m_pEntity->GetNetEntity()->GetChannelId();
+
+	// Token bucket at the weapon's rate, rounds past it are not fired nor relayed
+	const float maxAllowance = m_fireRate * kMaxFireBacklog;
+	const float levelTime = CFlightSystem::GetInstance().GetLevelTime();
+	if (m_serverFireTime >= 0.f && levelTime >= m_serverFireTime)
+		m_serverFireAllowance = std::min(m_serverFireAllowance + (levelTime - m_serverFireTime) * m_fireRate, maxAllowance);
+	else
+		m_serverFireAllowance = maxAllowance;
+	m_serverFireTime = levelTime;
+
+	for (uint8 i = 0; i < batch.count; ++i)
+	{
+		SFireEvent event = batch.events[i];
+		const uint8 allowedRounds = (uint8)std::min(m_serverFireAllowance, (float)event.burstCount);
+		if (allowedRounds == 0)
+			break;
+
+		event.burstCount = allowedRounds;
+		m_serverFireAllowance -= (float)allowedRounds;
+
+		// A shot the server can not vouch for is neither fired nor relayed. The hits are the authoritative result, for the damage.
+		SShotHits hits;
+		if (!ValidateShot(event, batch.interpolationDelay, hits))
+			continue;
+
+		// A remote shooter's rounds also fly on the server, the local one's were fired with the trigger
+		if (!IsLocalClient())
+			CBallisticsSystem::GetInstance().FireBurst(event.origin, event.direction, event.seed, event.burstCount, event.weapon, GetEntityId());
+
+		CFireReplication::GetInstance().Queue(GetEntityId(), channelId, event);
+	}
+	return true;
+}
+
+void CPlayerComponent::SendFireEvents(SFireEventPacket&& packet)
+{
+	SRmi<RMI_WRAP(&CPlayerComponent::ClientReceiveFireEvents)>::InvokeOnClient(this, std::move(packet), m_pEntity->GetNetEntity()->GetChannelId());
+}
+
+bool CPlayerComponent::ClientReceiveFireEvents(SFireEventPacket&& packet, INetChannel*)
+{
+	for (uint8 i = 0; i < packet.count; ++i)
+	{
+		const SFireEvent& event = packet.events[i];
+		CBallisticsSystem::GetInstance().FireBurst(event.origin, event.direction, event.seed, event.burstCount, event.weapon, packet.shooterIds[i]);
+	}
+	return true;
+}
+
 bool CPlayerComponent::ServerEnterVehicle(SerializeVehicleSwitchData&& data, INetChannel*)
 {
 	SRmi<RMI_WRAP(&CPlayerComponent::ClientEnterVehicle)>::InvokeOnAllClients(this, std::move(data));
@@ -768,6 +952,30 @@ bool CPlayerComponent::ClientApplyNewPosition(SerializeTransformData&& data, INe
 	return true;
 }
 
+void CPlayerComponent::SendShipSnapshot(SShipSnapshotPacket&& packet)
+{
+	SRmi<RMI_WRAP(&CPlayerComponent::ClientReceiveShipSnapshot)>::InvokeOnClient(this, std::move(packet), m_pEntity->GetNetEntity()->GetChannelId());
+}
+
+bool CPlayerComponent::ClientReceiveShipSnapshot(SShipSnapshotPacket&& packet, INetChannel*)
+{
+	CShipReplication::GetInstance().OnSnapshotReceived(packet.serverTime);
+
+	for (uint8 i = 0; i < packet.count; ++i)
+	{
+		const SShipSnapshotPacket::SShip& ship = packet.ships[i];
+		if (IEntity* pShipEntity = gEnv->pEntitySystem->GetEntity(ship.entityId))
+		{
+			if (CFlightController* pFlightController = pShipEntity->GetComponent<CFlightController>())
+			{
+				pFlightController->OnServerState(ship.state);
+			}
+		}
+	}
+
+	return true;
+}
+
 bool CPlayerComponent::ClientExitVehicle(NoParams&& data, INetChannel*)
 {
 	IEntity* vehicleEntity = GetEntity()->GetParent();
@@ -7,10 +7,14 @@
 #include <ICryMannequin.h>
 #include <CryMath/Cry_Camera.h>
 
+#include <Components/FireReplication.h>
 #include <Components/FlightModifiers.h>
+#include <Components/ShipInput.h>
+#include <Components/TransformHistory.h>
 
 
 class CVehicleComponent;
+struct SShipSnapshotPacket;
 
 namespace Cry::DefaultComponents
 {
@@ -154,6 +158,13 @@ class CPlayerComponent final : public IEntityComponent
 		}
 	};
 
+	// Rewound targets hit by the rounds of one fire event
+	struct SShotHits
+	{
+		uint8 count = 0;
+		std::array<CTransformHistory::SHit, SFireEvent::kMaxBurst> hits;
+	};
+
 public:
 
 	static constexpr EEntityAspects kPlayerAspect = eEA_GameClientA;
@@ -171,8 +182,10 @@ public:
 
 	virtual NetworkAspectType GetNetSerializeAspectMask() const override { return kPlayerAspect; }
 
-	bool ServerRequestFire(NoParams&& p, INetChannel*);
-	bool ClientFire(NoParams&& p, INetChannel*);
+	// Fire events are batched by the shooter and by the server, one message per network tick each way
+	bool ServerRequestFire(SFireBatch&& batch, INetChannel*);
+	void SendFireEvents(SFireEventPacket&& packet);
+	bool ClientReceiveFireEvents(SFireEventPacket&& packet, INetChannel*);
 
 	bool ServerEnterVehicle(SerializeVehicleSwitchData&& data, INetChannel*);
 	bool ClientEnterVehicle(SerializeVehicleSwitchData&& data, INetChannel*);
@@ -183,6 +196,10 @@ public:
 	bool ClientApplyNewPosition(SerializeTransformData&& data, INetChannel*);
 	bool ClientExitVehicle(NoParams&& data, INetChannel*);
 
+	// Server: sends this player's ship snapshot to its client (CShipReplication)
+	void SendShipSnapshot(SShipSnapshotPacket&& packet);
+	bool ClientReceiveShipSnapshot(SShipSnapshotPacket&& packet, INetChannel*);
+
 	// Reflect type to set a unique identifier for this component
 	static void ReflectType(Schematyc::CTypeDesc<CPlayerComponent>& desc)
 	{
@@ -206,19 +223,36 @@ public:
 	void OnReadyForGameplayOnServer();
 	bool IsLocalClient() const { return (m_pEntity->GetFlags() & ENTITY_FLAG_LOCAL_PLAYER) != 0; }
 
-	FlightModifierBitFlag GetFlightModifierState() const;
-	float GetAxisValue(const string& axisName);
+	// Ship input published this frame, read by the flight controller of the ship being piloted
+	const SShipInputSnapshot& GetShipInput() const { return m_shipInput; }
 
 protected: 
 
 	// Functions
 	void InitializePilotInput();
 	void InitializeShipInput();
+	void PublishShipInput();
 	void UpdatePlayerMovementRequest(float frameTime);
 	void UpdateLookDirectionRequest(float frameTime);
 	void UpdateAnimation(float frameTime);
 	void UpdateCamera(float frameTime);
+	// Boards the vehicle found by CVehicleIndex once a ray confirmed it is in sight
 	void Interact(int activationMode);
+	Vec3 GetEyePosition() const;
+	IEntity* FindBoardableVehicle() const;
+	// One CRayCastService ray in flight at a time, the answer comes a frame later
+	void CheckLineOfSight(const IEntity& vehicleEntity);
+	void UpdateInteractionPrompt();
+	void BoardVehicle(IEntity& vehicleEntity);
+	// World transform of the weapon's barrel, false if the character has none
+	bool GetBarrelTransform(QuatT& transform) const;
+	// Local shooter: fires the rounds right away and adds the event to the next batch
+	void Fire(uint8 burstCount);
+	void UpdateFire(float frameTime);
+	void SendFireBatch();
+	// Server: lag compensated check of the rounds of an event, false if the shot can not come from this shooter.
+	// outHits gets the rewound target of every round that hit, for the damage.
+	bool ValidateShot(const SFireEvent& event, float interpolationDelay, SShotHits& outHits) const;
 	void HandleInputFlagChange(CEnumFlags<EInputFlag> flags, CEnumFlags<EActionActivationMode> activationMode, EInputFlagType type = EInputFlagType::Hold);
 
 	// Respawn
@@ -272,21 +306,21 @@ private:
 	// Get CVar value
 	bool GetIsPiloting();
 
-	// Raycasting for interactions
-	IEntity* RayCast(Vec3 origin, Quat dir, IEntity& pSkipEntity) const;
 
 	// Ship variables
 	Vec3 m_position = ZERO;
 	Quat m_rotation = ZERO;
 
-	//Input maps flags
-	VectorMap<string, float> m_axisValues;
-	//VectorMap<string, int> m_keyStates;
+	//Ship input, written by the input callbacks and published once per frame
+	SShipInputSnapshot m_pendingShipInput;
+	SShipInputSnapshot m_shipInput;
 	FlightModifierBitFlag m_FlightModifierFlag;
 
 	const float m_cameraPitchMax = 1.5f; 
 	const float m_cameraPitchMin = -1.2f;
 	float m_playerInteractionRange = 10.f;
+	// Half angle of the view cone in which vehicles can be boarded
+	const float m_interactionConeCos = cosf(DEG2RAD(20.f));
 	float m_walkSpeed = 4.f;
 	float m_runSpeed = 7.f;
 	float m_jumpHeight = 2.f;
@@ -294,6 +328,21 @@ private:
 	bool hasGameStarted = false;
 	bool m_shouldStartOnVehicle = false;
 	bool m_isInteractPressed = false;
+	// Last vehicle the line of sight ray reached
+	EntityId m_visibleVehicleId = INVALID_ENTITYID;
+	bool m_isLineOfSightPending = false;
+
+	// Weapon, automatic fire while the trigger is held
+	const EWeaponType m_weaponType = EWeaponType::Rifle;
+	const float m_fireRate = 12.f;
+	bool m_isTriggerHeld = false;
+	float m_fireTimer = 0.f;
+	float m_fireSendTimer = 0.f;
+	uint32 m_fireSeed = 0;
+	SFireBatch m_fireBatch;
+	// Server: rounds the shooter may still fire, refilled at m_fireRate since m_serverFireTime (level time, < 0 before the first batch)
+	float m_serverFireAllowance = 0.f;
+	float m_serverFireTime = -1.f;
 
 	int m_cameraJointId = -1;
 	bool m_isVisible = true;
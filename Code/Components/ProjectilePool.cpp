@@ -0,0 +1,123 @@
+// Copyright 2017-2019 Crytek GmbH / Crytek Group. All rights reserved.
+#include "StdAfx.h"
+#include "ProjectilePool.h"
+
+#include <CrySystem/ConsoleRegistration.h>
+#include <CrySystem/IConsole.h>
+
+#include "Bullet.h"
+
+int CProjectilePool::s_poolSize = 256;
+
+void CProjectilePool::Prewarm()
+{
+	while (m_entityIds.size() < (size_t)s_poolSize)
+	{
+		const uint32 slot = (uint32)m_entityIds.size();
+		m_entityIds.push_back(INVALID_ENTITYID);
+		if (!SpawnProjectile(slot))
+		{
+			m_entityIds.pop_back();
+			return;
+		}
+		m_freeSlots.push_back(slot);
+	}
+}
+
+void CProjectilePool::Clear()
+{
+	m_entityIds.clear();
+	m_freeSlots.clear();
+}
+
+IMaterial* CProjectilePool::GetMaterial()
+{
+	// Looked up once, every pooled bullet shares it
+	if (!m_pMaterial)
+		m_pMaterial = gEnv->p3DEngine->GetMaterialManager()->LoadMaterial("Materials/bullet");
+
+	return m_pMaterial;
+}
+
+bool CProjectilePool::SpawnProjectile(uint32 slot)
+{
+	SEntitySpawnParams spawnParams;
+	spawnParams.pClass = gEnv->pEntitySystem->GetClassRegistry()->GetDefaultClass();
+	spawnParams.vScale = Vec3(GetBulletScale());
+
+	IEntity* pEntity = gEnv->pEntitySystem->SpawnEntity(spawnParams);
+	if (!pEntity)
+		return false;
+
+	pEntity->CreateComponentClass<CBulletComponent>()->Deactivate();
+	m_entityIds[slot] = pEntity->GetId();
+	return true;
+}
+
+CBulletComponent* CProjectilePool::GetBullet(uint32 slot)
+{
+	if (IEntity* pEntity = gEnv->pEntitySystem->GetEntity(m_entityIds[slot]))
+		return pEntity->GetComponent<CBulletComponent>();
+
+	// Removed from outside the pool (e.g. by a level reset), replaced in the same slot
+	if (SpawnProjectile(slot))
+		return gEnv->pEntitySystem->GetEntity(m_entityIds[slot])->GetComponent<CBulletComponent>();
+
+	return nullptr;
+}
+
+uint32 CProjectilePool::Acquire(const Matrix34& transform)
+{
+	if (m_freeSlots.empty())
+	{
+		// The pool size was raised since the level started
+		if (m_entityIds.size() >= (size_t)s_poolSize)
+			return kInvalidSlot;
+
+		m_entityIds.push_back(INVALID_ENTITYID);
+		m_freeSlots.push_back((uint32)m_entityIds.size() - 1);
+	}
+
+	const uint32 slot = m_freeSlots.back();
+	m_freeSlots.pop_back();
+
+	CBulletComponent* pBullet = GetBullet(slot);
+	if (!pBullet)
+	{
+		m_freeSlots.push_back(slot);
+		return kInvalidSlot;
+	}
+
+	pBullet->Show(transform);
+	return slot;
+}
+
+void CProjectilePool::Move(uint32 slot, const Matrix34& transform)
+{
+	if (CBulletComponent* pBullet = GetBullet(slot))
+		pBullet->Move(transform);
+}
+
+void CProjectilePool::Release(uint32 slot)
+{
+	if (CBulletComponent* pBullet = GetBullet(slot))
+		pBullet->Deactivate();
+
+	m_freeSlots.push_back(slot);
+}
+
+///////////////////////////////////////////////////////////////////////////
+// CONSOLE
+///////////////////////////////////////////////////////////////////////////
+void CProjectilePool::RegisterConsoleCommands()
+{
+	REGISTER_CVAR2("projectile_poolSize", &s_poolSize, s_poolSize, VF_NULL, "Bullet visuals spawned in advance when the level starts. Rounds fired past it fly without a visual");
+}
+
+void CProjectilePool::UnregisterConsoleCommands()
+{
+	if (gEnv->pConsole)
+	{
+		gEnv->pConsole->UnregisterVariable("projectile_poolSize");
+	}
+}
@@ -0,0 +1,58 @@
+// Copyright 2017-2021 Crytek GmbH / Crytek Group. All rights reserved.
+#pragma once
+#include <vector>
+
+#include <Cry3DEngine/IMaterial.h>
+
+class CBulletComponent;
+
+////////////////////////////////////////////////////////
+// Pre-warmed bullet visuals for the rounds of CBallisticsSystem, shown and moved instead of spawned and removed.
+// When none is free the round flies without a visual, the simulation does not depend on it.
+//   projectile_poolSize    visuals spawned when the level starts (the pool grows up to it if changed later)
+////////////////////////////////////////////////////////
+class CProjectilePool
+{
+public:
+	static constexpr uint32 kInvalidSlot = ~0u;
+
+	static CProjectilePool& GetInstance()
+	{
+		static CProjectilePool instance;
+		return instance;
+	}
+
+	// Spawns the pooled entities, once the level is loaded
+	void Prewarm();
+	// The entities go with the level, only the references are dropped
+	void Clear();
+
+	// A free visual shown at the transform, kInvalidSlot if the pool is exhausted
+	uint32 Acquire(const Matrix34& transform);
+	void Move(uint32 slot, const Matrix34& transform);
+	void Release(uint32 slot);
+
+	IMaterial* GetMaterial();
+
+	static float GetBulletScale() { return 0.05f; }
+
+	static void RegisterConsoleCommands();
+	static void UnregisterConsoleCommands();
+
+private:
+	CProjectilePool() = default;
+	CProjectilePool(const CProjectilePool&) = delete;
+	CProjectilePool& operator=(const CProjectilePool&) = delete;
+
+	bool SpawnProjectile(uint32 slot);
+	CBulletComponent* GetBullet(uint32 slot);
+
+	// Pooled entities by slot
+	std::vector<EntityId> m_entityIds;
+	std::vector<uint32> m_freeSlots;
+
+	_smart_ptr<IMaterial> m_pMaterial;
+
+	// CVars
+	static int s_poolSize;
+};
@@ -0,0 +1,139 @@
+// Copyright 2017-2019 Crytek GmbH / Crytek Group. All rights reserved.
+#include "StdAfx.h"
+#include "RayCastService.h"
+
+#include <CrySystem/ConsoleRegistration.h>
+#include <CrySystem/IConsole.h>
+#include <IGameFramework.h>
+
+int CRayCastService::s_debug = 0;
+
+void CRayCastService::Submit(const Vec3& origin, const Vec3& direction, EntityId skipEntityId, Callback&& callback, int objectTypes, uint32 flags)
+{
+	m_pending.push_back(SRequest{ origin, direction, skipEntityId, std::move(callback), objectTypes, flags });
+}
+
+void CRayCastService::Update()
+{
+	// Rays answered by the physics thread since the last update
+	for (SRay& ray : m_rays)
+	{
+		if (ray.state.load(std::memory_order_acquire) != ERayState::Done)
+			continue;
+
+		Dispatch(ray);
+		ray.request.callback = nullptr;
+		ray.state.store(ERayState::Free, std::memory_order_release);
+	}
+
+	// This frame's rays in one go, in submission order as long as there are free slots
+	size_t sentCount = 0;
+	size_t slot = 0;
+	for (; sentCount < m_pending.size(); ++sentCount)
+	{
+		while (slot < kMaxRays && m_rays[slot].state.load(std::memory_order_acquire) != ERayState::Free)
+			++slot;
+		if (slot == kMaxRays)
+			break;
+
+		Send(slot, std::move(m_pending[sentCount]));
+	}
+	m_pending.erase(m_pending.begin(), m_pending.begin() + sentCount);
+}
+
+void CRayCastService::Clear()
+{
+	m_pending.clear();
+
+	// Queued rays still get their answer from the physics thread, only their callbacks are dropped
+	for (SRay& ray : m_rays)
+	{
+		ray.request.callback = nullptr;
+		if (ray.state.load(std::memory_order_acquire) == ERayState::Done)
+			ray.state.store(ERayState::Free, std::memory_order_release);
+	}
+}
+
+void CRayCastService::Send(size_t slot, SRequest&& request)
+{
+	SRay& ray = m_rays[slot];
+	ray.request = std::move(request);
+	ray.hitCount = 0;
+
+	ray.pSkipEntity = nullptr;
+	if (IEntity* pEntity = gEnv->pEntitySystem->GetEntity(ray.request.skipEntityId))
+		ray.pSkipEntity = pEntity->GetPhysics();
+
+	SRWIParams params;
+	params.org = ray.request.origin;
+	params.dir = ray.request.direction;
+	params.objtypes = ray.request.objectTypes;
+	params.flags = ray.request.flags | rwi_queue;
+	params.hits = &ray.hit;
+	params.nMaxHits = 1;
+	params.pSkipEnts = ray.pSkipEntity ? &ray.pSkipEntity : nullptr;
+	params.nSkipEnts = ray.pSkipEntity ? 1 : 0;
+	params.pForeignData = this;
+	params.iForeignData = (int)slot;
+	params.OnEvent = &CRayCastService::OnRayResult;
+
+	// Before the call, the physics thread may answer right away
+	ray.state.store(ERayState::Queued, std::memory_order_release);
+	gEnv->pPhysicalWorld->RayWorldIntersection(params, "RayCastService");
+}
+
+int CRayCastService::OnRayResult(const EventPhysRWIResult* pResult)
+{
+	// Physics thread: only the slot of this ray is touched
+	CRayCastService* pService = static_cast<CRayCastService*>(pResult->pForeignData);
+	SRay& ray = pService->m_rays[pResult->iForeignData];
+
+	ray.hitCount = pResult->nHits;
+	if (pResult->nHits > 0 && pResult->pHits != &ray.hit)
+		ray.hit = pResult->pHits[0];
+
+	ray.state.store(ERayState::Done, std::memory_order_release);
+	return 1;
+}
+
+void CRayCastService::Dispatch(const SRay& ray) const
+{
+	SResult result;
+	if (ray.hitCount > 0 && ray.hit.pCollider)
+	{
+		result.isHit = true;
+		result.point = ray.hit.pt;
+		result.normal = ray.hit.n;
+		result.distance = ray.hit.dist;
+		result.surfaceId = ray.hit.surface_idx;
+		result.pEntity = gEnv->pEntitySystem->GetEntityFromPhysics(ray.hit.pCollider);
+	}
+
+	if (s_debug != 0)
+	{
+		IPersistantDebug* pPersistantDebug = gEnv->pGameFramework->GetIPersistantDebug();
+		pPersistantDebug->Begin("RayCastService", false);
+		pPersistantDebug->AddLine(ray.request.origin, result.isHit ? result.point : ray.request.origin + ray.request.direction, ColorF(1, 0, 0, 1), 1.f);
+		if (result.isHit)
+			pPersistantDebug->AddSphere(result.point, 0.25f, ColorF(Vec3(1, 1, 0), 0.5f), 1.f);
+	}
+
+	if (ray.request.callback)
+		ray.request.callback(result);
+}
+
+///////////////////////////////////////////////////////////////////////////
+// CONSOLE
+///////////////////////////////////////////////////////////////////////////
+void CRayCastService::RegisterConsoleCommands()
+{
+	REGISTER_CVAR2("raycast_debug", &s_debug, s_debug, VF_NULL, "1 draws the gameplay ray queries and their hits for a second");
+}
+
+void CRayCastService::UnregisterConsoleCommands()
+{
+	if (gEnv->pConsole)
+	{
+		gEnv->pConsole->UnregisterVariable("raycast_debug");
+	}
+}
@@ -0,0 +1,93 @@
+// Copyright 2017-2021 Crytek GmbH / Crytek Group. All rights reserved.
+#pragma once
+#include <array>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include <CryPhysics/physinterface.h>
+
+////////////////////////////////////////////////////////
+// Gameplay ray queries (interaction, sensors...), answered the frame after they are submitted.
+// Rays submitted during a frame are sent to the physics system together in Update, queued (rwi_queue) so they run on the physics thread,
+// and their callbacks are called on the main thread by a later Update.
+//   raycast_debug    1 draws every ray and its hit
+////////////////////////////////////////////////////////
+class CRayCastService
+{
+public:
+	struct SResult
+	{
+		bool isHit = false;
+		Vec3 point = ZERO;
+		Vec3 normal = ZERO;
+		float distance = 0.f;
+		int surfaceId = 0;
+		IEntity* pEntity = nullptr; // Entity of the physical entity hit, if any
+	};
+
+	using Callback = std::function<void(const SResult&)>;
+
+	// Rays in flight at once, the ones submitted past it wait for the next Update. Sized for a ray per live round (CBallisticsSystem).
+	static constexpr size_t kMaxRays = 2048;
+
+	static CRayCastService& GetInstance()
+	{
+		static CRayCastService instance;
+		return instance;
+	}
+
+	// direction carries the length of the ray. The callback runs in a later frame on the main thread.
+	void Submit(const Vec3& origin, const Vec3& direction, EntityId skipEntityId, Callback&& callback, int objectTypes = ent_all, uint32 flags = rwi_stop_at_pierceable | rwi_colltype_any);
+
+	// Main thread, once per frame: calls back the finished rays, then sends the rays submitted since the last update
+	void Update();
+	// Drops every ray, the callbacks are not called
+	void Clear();
+
+	static void RegisterConsoleCommands();
+	static void UnregisterConsoleCommands();
+
+private:
+	CRayCastService() = default;
+	CRayCastService(const CRayCastService&) = delete;
+	CRayCastService& operator=(const CRayCastService&) = delete;
+
+	struct SRequest
+	{
+		Vec3 origin;
+		Vec3 direction;
+		EntityId skipEntityId;
+		Callback callback;
+		int objectTypes;
+		uint32 flags;
+	};
+
+	enum class ERayState : uint8
+	{
+		Free,
+		Queued, // Sent to the physics thread
+		Done // Result written by the physics thread
+	};
+
+	// Fixed slots, the physics thread writes into the hit while the ray is queued
+	struct SRay
+	{
+		std::atomic<ERayState> state { ERayState::Free };
+		SRequest request;
+		IPhysicalEntity* pSkipEntity = nullptr;
+		ray_hit hit;
+		int hitCount = 0;
+	};
+
+	static int OnRayResult(const EventPhysRWIResult* pResult);
+
+	void Dispatch(const SRay& ray) const;
+	void Send(size_t slot, SRequest&& request);
+
+	std::array<SRay, kMaxRays> m_rays;
+	std::vector<SRequest> m_pending;
+
+	// CVars
+	static int s_debug;
+};
@@ -0,0 +1,135 @@
+// Copyright 2017-2019 Crytek GmbH / Crytek Group. All rights reserved.
+#include "StdAfx.h"
+#include "RemoteInputQueue.h"
+
+#include <algorithm>
+
+namespace
+{
+	// About a second of flight steps between two depth adjustments
+	constexpr uint32 kAdaptWindow = 60;
+}
+
+void CRemoteInputQueue::Push(const INetChannel* pChannel, uint32 sequence, const SQuantizedShipInput& input)
+{
+	if (pChannel != m_pChannel)
+	{
+		Reset();
+		m_pChannel = pChannel;
+	}
+
+	if (m_nextSequence == 0)
+		m_nextSequence = sequence;
+
+	// Consumed or replaced by a repeat already
+	if (sequence < m_nextSequence)
+		return;
+
+	// Too far ahead to be stored (long stall on the server): skip to the buffer depth behind it
+	if (sequence >= m_nextSequence + kCapacity)
+	{
+		m_nextSequence = sequence - m_targetDepth + 1;
+	}
+
+	SSlot& slot = m_slots[sequence % kCapacity];
+	slot.sequence = sequence;
+	slot.input = input;
+	m_newestSequence = std::max(m_newestSequence, sequence);
+}
+
+void CRemoteInputQueue::Reset()
+{
+	for (SSlot& slot : m_slots)
+		slot.sequence = 0;
+
+	m_pChannel = nullptr;
+	m_nextSequence = 0;
+	m_newestSequence = 0;
+	m_isPlaying = false;
+	m_starvedSteps = 0;
+	m_lastInput = SQuantizedShipInput();
+	m_lastSequence = 0;
+	m_targetDepth = kMinDepth;
+	m_windowSteps = 0;
+	m_windowMinDepth = kCapacity;
+	m_windowUnderruns = 0;
+}
+
+bool CRemoteInputQueue::Consume(uint32& sequence, SQuantizedShipInput& input)
+{
+	if (m_nextSequence == 0)
+		return false;
+
+	const uint32 depth = GetDepth();
+
+	// Fill the buffer before playing, after a reset or a starvation
+	if (!m_isPlaying)
+	{
+		if (depth < m_targetDepth)
+			return false;
+		m_isPlaying = true;
+	}
+
+	if (depth == 0)
+	{
+		// The pilot stopped sending (left the ship, lost connection): stop repeating and refill before playing again
+		if (m_starvedSteps == kMaxDepth)
+		{
+			m_isPlaying = false;
+			return false;
+		}
+
+		// Nothing received yet for this step: repeat the last input and wait for the next one, the queue is one step deeper from now on
+		++m_starvedSteps;
+		Adapt(depth, true);
+	}
+	else
+	{
+		const SSlot& slot = m_slots[m_nextSequence % kCapacity];
+		if (slot.sequence == m_nextSequence)
+		{
+			m_lastInput = slot.input;
+			m_lastSequence = m_nextSequence;
+		}
+		// else lost, newer inputs are here already: the last input stands in for it
+
+		++m_nextSequence;
+		m_starvedSteps = 0;
+		Adapt(depth, false);
+	}
+
+	sequence = m_lastSequence;
+	input = m_lastInput;
+	return true;
+}
+
+void CRemoteInputQueue::Adapt(uint32 depth, bool underrun)
+{
+	m_windowMinDepth = std::min(m_windowMinDepth, depth);
+	if (underrun)
+	{
+		++m_windowUnderruns;
+		if (m_targetDepth < kMaxDepth)
+			++m_targetDepth;
+	}
+
+	if (++m_windowSteps < kAdaptWindow)
+		return;
+
+	// A whole window without running dry: the buffer always held more than needed, one input is dropped to cut the latency
+	if (m_windowUnderruns == 0)
+	{
+		if (m_windowMinDepth > m_targetDepth + 1)
+		{
+			++m_nextSequence;
+		}
+		else if (m_targetDepth > kMinDepth)
+		{
+			--m_targetDepth;
+		}
+	}
+
+	m_windowSteps = 0;
+	m_windowMinDepth = kCapacity;
+	m_windowUnderruns = 0;
+}
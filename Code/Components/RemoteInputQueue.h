@@ -0,0 +1,64 @@
+// Copyright 2017-2021 Crytek GmbH / Crytek Group. All rights reserved.
+#pragma once
+#include <array>
+
+#include <Components/ShipInput.h>
+
+struct INetChannel;
+
+////////////////////////////////////////////////////////
+// Server side input queue of a remote pilot, tied to the channel the inputs come from.
+// Inputs are stored by sequence and consumed exactly one per flight step, a few steps behind the newest one (jitter buffer).
+// The buffer depth adapts: it grows when the queue runs dry and shrinks when inputs keep piling up.
+// A missing input is replaced by the last one applied.
+////////////////////////////////////////////////////////
+class CRemoteInputQueue
+{
+public:
+	static constexpr uint32 kCapacity = 32;
+
+	// Buffer depth in steps, the queue starts at kMinDepth
+	static constexpr uint32 kMinDepth = 2;
+	static constexpr uint32 kMaxDepth = 12;
+
+	CRemoteInputQueue() = default;
+
+	// Inputs from another channel (new pilot, reconnection) restart the queue. Sequences already consumed are dropped.
+	void Push(const INetChannel* pChannel, uint32 sequence, const SQuantizedShipInput& input);
+	void Reset();
+
+	// Once per flight step. False until the buffer is filled, or when the pilot has stopped sending.
+	// sequence is the last input applied in order (acknowledged to the pilot), input the one to apply this step (repeated if missing)
+	bool Consume(uint32& sequence, SQuantizedShipInput& input);
+
+	// False once reset, until the next input arrives
+	bool HasInputs() const { return m_nextSequence != 0; }
+	uint32 GetTargetDepth() const { return m_targetDepth; }
+
+private:
+	struct SSlot
+	{
+		uint32 sequence = 0;
+		SQuantizedShipInput input;
+	};
+
+	uint32 GetDepth() const { return m_newestSequence >= m_nextSequence ? m_newestSequence - m_nextSequence + 1 : 0; }
+	void Adapt(uint32 depth, bool underrun);
+
+	std::array<SSlot, kCapacity> m_slots;
+	const INetChannel* m_pChannel = nullptr;
+
+	uint32 m_nextSequence = 0; // 0 until the first input arrives
+	uint32 m_newestSequence = 0;
+	bool m_isPlaying = false;
+	uint32 m_starvedSteps = 0; // Consecutive steps without input
+
+	SQuantizedShipInput m_lastInput;
+	uint32 m_lastSequence = 0;
+
+	// Depth adaptation, measured over windows of kAdaptWindow steps
+	uint32 m_targetDepth = kMinDepth;
+	uint32 m_windowSteps = 0;
+	uint32 m_windowMinDepth = kCapacity;
+	uint32 m_windowUnderruns = 0;
+};
@@ -0,0 +1,77 @@
+// ShipInput.h
+#pragma once
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+#include <Components/FlightModifiers.h>
+
+// Every axis a pilot can drive, used as an index into SShipInputSnapshot
+enum class EShipAxis : uint8_t
+{
+    AccelForward = 0,
+    AccelBackward,
+    AccelLeft,
+    AccelRight,
+    AccelUp,
+    AccelDown,
+    RollLeft,
+    RollRight,
+    Yaw,
+    Pitch,
+    Count
+};
+
+// Plain copy of the pilot's ship input, published by the player once per frame and read by index by the flight controller
+struct SShipInputSnapshot
+{
+    std::array<float, (size_t)EShipAxis::Count> axes = {};
+    FlightModifierBitFlag modifiers;
+
+    float GetAxis(EShipAxis axis) const
+    {
+        return axes[(size_t)axis];
+    }
+
+    void SetAxis(EShipAxis axis, float value)
+    {
+        axes[(size_t)axis] = value;
+    }
+};
+
+// Network form of a normalized snapshot (every axis in [-1, 1]). Pitch and yaw follow the mouse and keep 16 bits, the other axes fit in a byte.
+struct SQuantizedShipInput
+{
+    static constexpr size_t kByteAxisCount = (size_t)EShipAxis::Yaw;
+    static constexpr size_t kAimAxisCount = (size_t)EShipAxis::Count - kByteAxisCount;
+
+    std::array<int8_t, kByteAxisCount> byteAxes = {};
+    std::array<int16_t, kAimAxisCount> aimAxes = {};
+    uint8_t modifiers = 0;
+
+    void Pack(const SShipInputSnapshot& input)
+    {
+        for (size_t i = 0; i < kByteAxisCount; ++i)
+            byteAxes[i] = (int8_t)std::lround(Clamp(input.axes[i]) * 127.f);
+        for (size_t i = 0; i < kAimAxisCount; ++i)
+            aimAxes[i] = (int16_t)std::lround(Clamp(input.axes[kByteAxisCount + i]) * 32767.f);
+        modifiers = input.modifiers.GetValue();
+    }
+
+    SShipInputSnapshot Unpack() const
+    {
+        SShipInputSnapshot input;
+        for (size_t i = 0; i < kByteAxisCount; ++i)
+            input.axes[i] = Clamp((float)byteAxes[i] / 127.f);
+        for (size_t i = 0; i < kAimAxisCount; ++i)
+            input.axes[kByteAxisCount + i] = Clamp((float)aimAxes[i] / 32767.f);
+        input.modifiers.SetValue(modifiers);
+        return input;
+    }
+
+private:
+    static float Clamp(float value)
+    {
+        return value < -1.f ? -1.f : (value > 1.f ? 1.f : value);
+    }
+};
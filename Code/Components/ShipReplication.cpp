@@ -0,0 +1,227 @@
+// Copyright 2017-2019 Crytek GmbH / Crytek Group. All rights reserved.
+#include "StdAfx.h"
+#include "ShipReplication.h"
+
+#include <algorithm>
+#include <CrySystem/ConsoleRegistration.h>
+#include <CrySystem/IConsole.h>
+
+#include "GamePlugin.h"
+#include <Components/FlightController.h>
+#include <Components/FlightSystem.h>
+#include <Components/Player.h>
+
+namespace
+{
+	// Distance at which a ship's priority is halved
+	constexpr float kPriorityDistance = 200.f;
+	// Closing speed at which a ship's priority is doubled
+	constexpr float kPriorityClosingSpeed = 100.f;
+	// Ships within this cone of the view direction count as targeted
+	const float kTargetConeCos = cosf(DEG2RAD(10.f));
+	constexpr float kTargetPriority = 4.f;
+}
+
+int CShipReplication::s_bytesPerSecond = 16000;
+float CShipReplication::s_relevanceRadius = 5000.f;
+
+void CShipReplication::Update(float frameTime)
+{
+	if (!gEnv->bServer || gEnv->IsEditing())
+		return;
+
+	// Ticks at the snapshot rate, 0 ticks every frame
+	const int snapshotRate = CFlightSystem::GetSnapshotRate();
+	m_tickTimer -= frameTime;
+	if (snapshotRate > 0 && m_tickTimer > 0.f)
+		return;
+
+	const float tickTime = snapshotRate > 0 ? 1.f / (float)snapshotRate : frameTime;
+	m_tickTimer = std::max(m_tickTimer + tickTime, 0.f);
+
+	for (std::pair<const int, SClient>& client : m_clients)
+	{
+		client.second.isConnected = false;
+	}
+
+	CGamePlugin::GetInstance()->IterateOverPlayers([this, tickTime](CPlayerComponent& player)
+	{
+		// The host simulates every ship itself
+		if (player.IsLocalClient())
+			return;
+
+		IEntity* pPlayerEntity = player.GetEntity();
+		const int channelId = pPlayerEntity->GetNetEntity()->GetChannelId();
+
+		// Seated pilots are children of their ship
+		SViewer viewer;
+		viewer.position = pPlayerEntity->GetWorldPos();
+		viewer.viewDirection = pPlayerEntity->GetWorldRotation().GetColumn1();
+		if (IEntity* pParent = pPlayerEntity->GetParent())
+		{
+			if (const CFlightController* pShip = pParent->GetComponent<CFlightController>())
+			{
+				viewer.pOwnShip = pShip;
+				if (IPhysicalEntity* pPhysicalEntity = pParent->GetPhysicalEntity())
+				{
+					pe_status_dynamics dynamics;
+					if (pPhysicalEntity->GetStatus(&dynamics))
+						viewer.velocity = dynamics.v;
+				}
+			}
+		}
+
+		SClient& client = m_clients[channelId];
+		client.isConnected = true;
+		ReplicateToClient(player, viewer, client, tickTime);
+	});
+
+	// Forget disconnected clients
+	for (auto it = m_clients.begin(); it != m_clients.end();)
+	{
+		if (it->second.isConnected)
+			++it;
+		else
+			it = m_clients.erase(it);
+	}
+}
+
+void CShipReplication::OnSnapshotReceived(float serverTime)
+{
+	// Unordered, an older snapshot arriving late says nothing new
+	if (serverTime <= m_snapshotServerTime)
+		return;
+
+	m_snapshotServerTime = serverTime;
+	m_snapshotLocalTime = CFlightSystem::GetInstance().GetLevelTime();
+}
+
+float CShipReplication::GetEstimatedServerTime() const
+{
+	if (m_snapshotServerTime <= 0.f)
+		return 0.f;
+
+	return m_snapshotServerTime + (CFlightSystem::GetInstance().GetLevelTime() - m_snapshotLocalTime);
+}
+
+void CShipReplication::Clear()
+{
+	m_clients.clear();
+	m_candidates.clear();
+	m_tickTimer = 0.f;
+	m_snapshotServerTime = 0.f;
+	m_snapshotLocalTime = 0.f;
+}
+
+void CShipReplication::ReplicateToClient(CPlayerComponent& player, const SViewer& viewer, SClient& client, float tickTime)
+{
+	const std::vector<CFlightController*>& controllers = CFlightSystem::GetInstance().GetControllers();
+	client.accumulators.resize(controllers.size(), 0.f);
+
+	SShipSnapshotPacket packet;
+	packet.serverTime = CFlightSystem::GetInstance().GetLevelTime();
+
+	int budget = (int)((float)s_bytesPerSecond * tickTime) - kSnapshotHeaderBytes;
+	const float relevanceRadiusSq = s_relevanceRadius * s_relevanceRadius;
+
+	m_candidates.clear();
+	for (size_t slot = 0; slot < controllers.size(); ++slot)
+	{
+		CFlightController* pController = controllers[slot];
+		if (!pController)
+		{
+			client.accumulators[slot] = 0.f;
+			continue;
+		}
+
+		// Own ship: needed every tick for the prediction, sent first and outside the order
+		if (pController == viewer.pOwnShip)
+		{
+			AddShip(packet, *pController, true);
+			budget -= kShipStateBytes + SShipNetState::kOwnShipBytes;
+			client.accumulators[slot] = 0.f;
+			continue;
+		}
+
+		const IEntity* pShipEntity = pController->GetEntity();
+		const Vec3 shipPosition = pShipEntity->GetWorldPos();
+		if ((shipPosition - viewer.position).GetLengthSquared() > relevanceRadiusSq)
+		{
+			client.accumulators[slot] = 0.f;
+			continue;
+		}
+
+		Vec3 shipVelocity(ZERO);
+		if (IPhysicalEntity* pPhysicalEntity = pShipEntity->GetPhysicalEntity())
+		{
+			pe_status_dynamics dynamics;
+			if (pPhysicalEntity->GetStatus(&dynamics))
+				shipVelocity = dynamics.v;
+		}
+
+		client.accumulators[slot] += GetPriority(viewer, shipPosition, shipVelocity) * tickTime;
+		m_candidates.push_back(SCandidate{ client.accumulators[slot], slot });
+	}
+
+	std::sort(m_candidates.begin(), m_candidates.end());
+
+	// Ships left out keep their accumulated priority and move up for the next tick
+	for (const SCandidate& candidate : m_candidates)
+	{
+		if (budget < kShipStateBytes || packet.count == SShipSnapshotPacket::kMaxShips)
+			break;
+
+		AddShip(packet, *controllers[candidate.slot], false);
+		client.accumulators[candidate.slot] = 0.f;
+		budget -= kShipStateBytes;
+	}
+
+	// One message per client per tick, whatever the number of ships and pilot frame rates
+	if (packet.count > 0)
+	{
+		player.SendShipSnapshot(std::move(packet));
+	}
+}
+
+void CShipReplication::AddShip(SShipSnapshotPacket& packet, CFlightController& controller, bool isOwnShip)
+{
+	SShipSnapshotPacket::SShip& ship = packet.ships[packet.count++];
+	ship.entityId = controller.GetEntityId();
+	controller.GetNetState(ship.state, isOwnShip);
+}
+
+float CShipReplication::GetPriority(const SViewer& viewer, const Vec3& shipPosition, const Vec3& shipVelocity)
+{
+	const Vec3 offset = shipPosition - viewer.position;
+	const float distance = offset.GetLength();
+	const Vec3 direction = distance > FLT_EPSILON ? offset / distance : Vec3(ZERO);
+
+	// Positive when the ship and the viewer get closer
+	const float closingSpeed = std::max(-(shipVelocity - viewer.velocity).Dot(direction), 0.f);
+
+	float priority = (1.f + closingSpeed / kPriorityClosingSpeed) / (1.f + distance / kPriorityDistance);
+
+	// No target locking yet, the ship in the crosshair stands in for the target
+	if (direction.Dot(viewer.viewDirection) > kTargetConeCos)
+		priority *= kTargetPriority;
+
+	return priority;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// CONSOLE
+///////////////////////////////////////////////////////////////////////////
+void CShipReplication::RegisterConsoleCommands()
+{
+	REGISTER_CVAR2("flight_replicationBudget", &s_bytesPerSecond, s_bytesPerSecond, VF_NULL, "Bytes per second of ship states sent to each client, the highest priority ships are sent first");
+	REGISTER_CVAR2("flight_relevanceRadius", &s_relevanceRadius, s_relevanceRadius, VF_NULL, "Ships further than this from a client (m) are not replicated to it");
+}
+
+void CShipReplication::UnregisterConsoleCommands()
+{
+	if (gEnv->pConsole)
+	{
+		gEnv->pConsole->UnregisterVariable("flight_replicationBudget");
+		gEnv->pConsole->UnregisterVariable("flight_relevanceRadius");
+	}
+}
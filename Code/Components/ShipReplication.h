@@ -0,0 +1,117 @@
+// Copyright 2017-2021 Crytek GmbH / Crytek Group. All rights reserved.
+#pragma once
+#include <array>
+#include <unordered_map>
+#include <vector>
+
+#include <Components/FlightController.h>
+
+class CPlayerComponent;
+
+// Every ship state a client gets in one replication tick, sent as a single message to its player
+struct SShipSnapshotPacket
+{
+	static constexpr uint8 kMaxShips = 32;
+
+	struct SShip
+	{
+		EntityId entityId = INVALID_ENTITYID;
+		SShipNetState state;
+	};
+
+	float serverTime = 0.f; // CFlightSystem::GetLevelTime on the server
+	uint8 count = 0;
+	std::array<SShip, kMaxShips> ships;
+
+	void SerializeWith(TSerialize ser)
+	{
+		ser.Value("serverTime", serverTime);
+		ser.Value("count", count);
+		if (count > kMaxShips)
+			count = kMaxShips;
+
+		for (uint8 i = 0; i < count; ++i)
+		{
+			ser.Value("entityId", ships[i].entityId, 'eid');
+			ships[i].state.SerializeWith(ser);
+			ships[i].state.serverTime = serverTime;
+		}
+	}
+};
+
+////////////////////////////////////////////////////////
+// Server side interest management for ship states. Every flight_snapshotRate tick each client gets one snapshot with its own selection of ships:
+// each ship's priority (distance, closing speed, in the crosshair) accumulates every tick it is not sent,
+// and ships are sent in accumulated order until the client's byte budget for the tick is spent.
+// The client's own ship is always sent, ships beyond flight_relevanceRadius are never sent.
+////////////////////////////////////////////////////////
+class CShipReplication
+{
+public:
+	static CShipReplication& GetInstance()
+	{
+		static CShipReplication instance;
+		return instance;
+	}
+
+	// Server only, called once per frame
+	void Update(float frameTime);
+	void Clear();
+
+	// Client: a snapshot arrived, its server time keeps the estimate of the server clock
+	void OnSnapshotReceived(float serverTime);
+	// Client: current server time as seen through the snapshots (latency included), 0 before the first one
+	float GetEstimatedServerTime() const;
+
+	static void RegisterConsoleCommands();
+	static void UnregisterConsoleCommands();
+
+private:
+	CShipReplication() = default;
+	CShipReplication(const CShipReplication&) = delete;
+	CShipReplication& operator=(const CShipReplication&) = delete;
+
+	// Uncompressed size of the snapshot header and of a ship in it (the own ship adds SShipNetState::kOwnShipBytes), used against the budget
+	static constexpr int kSnapshotHeaderBytes = (int)(sizeof(float) + sizeof(uint8));
+	static constexpr int kShipStateBytes = (int)sizeof(EntityId) + SShipNetState::kSharedBytes;
+
+	struct SViewer
+	{
+		Vec3 position = ZERO;
+		Vec3 velocity = ZERO;
+		Vec3 viewDirection = FORWARD_DIRECTION;
+		const CFlightController* pOwnShip = nullptr;
+	};
+
+	struct SClient
+	{
+		// Accumulated priority per flight system slot
+		std::vector<float> accumulators;
+		bool isConnected = false;
+	};
+
+	struct SCandidate
+	{
+		float priority;
+		size_t slot;
+
+		// Highest priority first
+		bool operator<(const SCandidate& other) const { return priority > other.priority; }
+	};
+
+	void ReplicateToClient(CPlayerComponent& player, const SViewer& viewer, SClient& client, float tickTime);
+	static void AddShip(SShipSnapshotPacket& packet, CFlightController& controller, bool isOwnShip);
+	static float GetPriority(const SViewer& viewer, const Vec3& shipPosition, const Vec3& shipVelocity);
+
+	std::unordered_map<int, SClient> m_clients;
+	std::vector<SCandidate> m_candidates;
+	float m_tickTimer = 0.f;
+
+	// Client: newest snapshot server time, and the local time it arrived at
+	float m_snapshotServerTime = 0.f;
+	float m_snapshotLocalTime = 0.f;
+
+	// CVars
+	static int s_bytesPerSecond;
+	static float s_relevanceRadius;
+};
@@ -0,0 +1,112 @@
+// Copyright 2017-2019 Crytek GmbH / Crytek Group. All rights reserved.
+#include "StdAfx.h"
+#include "ShipSnapshotBuffer.h"
+
+#include <algorithm>
+
+namespace
+{
+	// Playback further than this from where it should be is snapped instead of eased (ship respawned, long stall)
+	constexpr float kMaxPlaybackDrift = 1.f;
+	// Fraction of the playback drift removed per second
+	constexpr float kPlaybackCorrectionRate = 2.f;
+}
+
+void CShipSnapshotBuffer::Push(const SShipSnapshot& snapshot)
+{
+	if (m_count > 0 && snapshot.time <= Get(m_count - 1).time)
+		return;
+
+	if (m_count == kCapacity)
+		DropOldest();
+
+	m_snapshots[(m_head + m_count) % kCapacity] = snapshot;
+	++m_count;
+}
+
+void CShipSnapshotBuffer::Clear()
+{
+	m_head = 0;
+	m_count = 0;
+}
+
+void CShipSnapshotBuffer::DropOldest()
+{
+	m_head = (m_head + 1) % kCapacity;
+	--m_count;
+}
+
+bool CShipSnapshotBuffer::Sample(float frameTime, float interpolationDelay, float maxExtrapolation, SShipSnapshot& result)
+{
+	if (m_count == 0)
+		return false;
+
+	// The playback clock runs at the local rate and is eased toward the target, so jitter in arrival times does not show
+	const float targetTime = Get(m_count - 1).time - interpolationDelay;
+	m_playbackTime += frameTime;
+
+	const float drift = targetTime - m_playbackTime;
+	if (fabsf(drift) > kMaxPlaybackDrift)
+		m_playbackTime = targetTime;
+	else
+		m_playbackTime += drift * std::min(kPlaybackCorrectionRate * frameTime, 1.f);
+
+	// Snapshots entirely behind the playback time are not needed anymore
+	while (m_count > 1 && Get(1).time <= m_playbackTime)
+		DropOldest();
+
+	const SShipSnapshot& from = Get(0);
+	if (m_playbackTime <= from.time)
+	{
+		result = from;
+	}
+	else if (m_count > 1)
+	{
+		Interpolate(from, Get(1), m_playbackTime, result);
+	}
+	else
+	{
+		// Late snapshot: keep going along the last known motion for a while, then hold
+		Extrapolate(from, std::min(m_playbackTime, from.time + maxExtrapolation), result);
+	}
+
+	result.time = m_playbackTime;
+	return true;
+}
+
+void CShipSnapshotBuffer::Interpolate(const SShipSnapshot& from, const SShipSnapshot& to, float time, SShipSnapshot& result)
+{
+	const float duration = to.time - from.time;
+	const float t = crymath::clamp((time - from.time) / duration, 0.f, 1.f);
+	const float t2 = t * t;
+	const float t3 = t2 * t;
+
+	// Cubic Hermite basis, the tangents are the velocities scaled to the interval
+	const float h00 = 2.f * t3 - 3.f * t2 + 1.f;
+	const float h10 = t3 - 2.f * t2 + t;
+	const float h01 = -2.f * t3 + 3.f * t2;
+	const float h11 = t3 - t2;
+	result.position = from.position * h00 + from.velocity * (h10 * duration) + to.position * h01 + to.velocity * (h11 * duration);
+
+	// Derivative of the curve, keeps physics consistent with the path between two updates
+	const float d00 = 6.f * t2 - 6.f * t;
+	const float d10 = 3.f * t2 - 4.f * t + 1.f;
+	const float d01 = -d00;
+	const float d11 = 3.f * t2 - 2.f * t;
+	result.velocity = (from.position * d00 + to.position * d01) / duration + from.velocity * d10 + to.velocity * d11;
+
+	result.orientation.SetSlerp(from.orientation, to.orientation, t);
+	result.angularVelocity = Vec3::CreateLerp(from.angularVelocity, to.angularVelocity, t);
+}
+
+void CShipSnapshotBuffer::Extrapolate(const SShipSnapshot& from, float time, SShipSnapshot& result)
+{
+	const float elapsed = time - from.time;
+
+	result = from;
+	result.position += from.velocity * elapsed;
+
+	const float angularSpeed = from.angularVelocity.GetLength();
+	if (angularSpeed > FLT_EPSILON)
+		result.orientation = (Quat::CreateRotationAA(angularSpeed * elapsed, from.angularVelocity / angularSpeed) * from.orientation).GetNormalized();
+}
@@ -0,0 +1,48 @@
+// Copyright 2017-2021 Crytek GmbH / Crytek Group. All rights reserved.
+#pragma once
+#include <array>
+
+// Replicated state of a ship at a point of the server timeline
+struct SShipSnapshot
+{
+	float time = 0.f;
+	Vec3 position = ZERO;
+	Quat orientation = IDENTITY;
+	Vec3 velocity = ZERO;
+	Vec3 angularVelocity = ZERO;
+};
+
+////////////////////////////////////////////////////////
+// Snapshots received for a remote ship, played back a fixed delay behind the newest one.
+// Position is a cubic Hermite curve through the replicated velocities, orientation a slerp.
+// Past the newest snapshot the ship is extrapolated for a bounded time, then held.
+////////////////////////////////////////////////////////
+class CShipSnapshotBuffer
+{
+public:
+	static constexpr size_t kCapacity = 32;
+
+	CShipSnapshotBuffer() = default;
+
+	// Snapshots older than the newest one (reordered or duplicated) are dropped
+	void Push(const SShipSnapshot& snapshot);
+	void Clear();
+	bool IsEmpty() const { return m_count == 0; }
+
+	// Advances the playback clock by frameTime, kept interpolationDelay behind the newest snapshot. False if there is nothing to play.
+	bool Sample(float frameTime, float interpolationDelay, float maxExtrapolation, SShipSnapshot& result);
+
+private:
+	const SShipSnapshot& Get(size_t index) const { return m_snapshots[(m_head + index) % kCapacity]; }
+	void DropOldest();
+
+	static void Interpolate(const SShipSnapshot& from, const SShipSnapshot& to, float time, SShipSnapshot& result);
+	static void Extrapolate(const SShipSnapshot& from, float time, SShipSnapshot& result);
+
+	std::array<SShipSnapshot, kCapacity> m_snapshots;
+	size_t m_head = 0;
+	size_t m_count = 0;
+
+	// Playback time on the server timeline
+	float m_playbackTime = 0.f;
+};
@@ -29,13 +29,21 @@ CRY_STATIC_AUTO_REGISTER_FUNCTION(&RegisterShipThrusterComponent)
 
 void CShipThrusterComponent::Initialize()
 {
-	// Initialize stuff
+	// Hand the thruster to the ship's control allocation, if the controller is not there yet it picks us up itself
+	if (CFlightController* pFlightController = m_pEntity->GetComponent<CFlightController>())
+		pFlightController->RegisterThruster(this);
+}
+
+void CShipThrusterComponent::OnShutDown()
+{
+	if (CFlightController* pFlightController = m_pEntity->GetComponent<CFlightController>())
+		pFlightController->UnregisterThruster(this);
 }
 
 Cry::Entity::EventFlags CShipThrusterComponent::GetEventMask() const
 {
 	//Listening to the update event
-	return EEntityEvent::Update | EEntityEvent::GameplayStarted;
+	return EEntityEvent::Update | EEntityEvent::GameplayStarted | EEntityEvent::EditorPropertyChanged;
 }
 
 void CShipThrusterComponent::ProcessEvent(const SEntityEvent& event)
@@ -50,6 +58,13 @@ void CShipThrusterComponent::ProcessEvent(const SEntityEvent& event)
 	case EEntityEvent::Update:
 	{
 
+	}
+	break;
+	case EEntityEvent::EditorPropertyChanged:
+	{
+		// Layout changed, the allocation has to be rebuilt
+		if (CFlightController* pFlightController = m_pEntity->GetComponent<CFlightController>())
+			pFlightController->OnThrusterLayoutChanged();
 	}
 	break;
 	case Cry::Entity::EEvent::Reset:
@@ -61,28 +76,47 @@ void CShipThrusterComponent::ProcessEvent(const SEntityEvent& event)
 	}
 }
 
-void CShipThrusterComponent::ApplyLinearImpulse(IPhysicalEntity* pPhysicalEntity, const Vec3& linearImpulse)
+void CShipThrusterComponent::SetThrusterState(EShipThrusterState state)
+{
+	if (m_currentThrusterState == state)
+		return;
+
+	m_currentThrusterState = state;
+	if (CFlightController* pFlightController = m_pEntity->GetComponent<CFlightController>())
+		pFlightController->OnThrusterLayoutChanged();
+}
+
+float CShipThrusterComponent::GetAvailableForce() const
+{
+	switch (m_currentThrusterState)
+	{
+	case EShipThrusterState::Inactive:
+		return 0.f;
+	case EShipThrusterState::Overclock:
+		return m_maxForce * m_overclockMultiplier;
+	default:
+		return m_maxForce;
+	}
+}
+
+void CShipThrusterComponent::ApplyLinearImpulse(const Vec3& linearImpulse)
 {
 	if (m_pEntity->GetComponent<CVehicleComponent>()->GetIsPiloting())
 	{
-		if (pPhysicalEntity)
+		if (CFlightController* pFlightController = m_pEntity->GetComponent<CFlightController>())
 		{
-			// Apply the force at the specified position and rotation
-			impulseAction.impulse = linearImpulse;
-			pPhysicalEntity->Action(&impulseAction);
+			pFlightController->AddImpulse(linearImpulse, Vec3(ZERO));
 		}
 	}
 }
 
-void CShipThrusterComponent::ApplyAngularImpulse(IPhysicalEntity* pPhysicalEntity, const Vec3& angularImpulse)
+void CShipThrusterComponent::ApplyAngularImpulse(const Vec3& angularImpulse)
 {
 	if (m_pEntity->GetComponent<CVehicleComponent>()->GetIsPiloting())
 	{
-		if (pPhysicalEntity)
+		if (CFlightController* pFlightController = m_pEntity->GetComponent<CFlightController>())
 		{
-			pe_action_impulse torqueAction;
-			torqueAction.angImpulse = angularImpulse;
-			pPhysicalEntity->Action(&torqueAction);
+			pFlightController->AddImpulse(Vec3(ZERO), angularImpulse);
 		}
 	}
 }
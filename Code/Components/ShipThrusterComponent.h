@@ -26,10 +26,20 @@ public:
 	static void ReflectType(Schematyc::CTypeDesc<CShipThrusterComponent>& desc)
 	{
 		desc.SetGUID("{F0FD2A0A-DD3F-45D5-BBE7-4BCBBBF296BD}"_cry_guid);
-		desc.SetComponentFlags({ IEntityComponent::EFlags::HideFromInspector });
+		desc.SetEditorCategory("Flight");
+		desc.SetLabel("ShipThruster");
+		desc.SetDescription("A thruster of the ship, throttled by the flight controller.");
+
+		// Layout, in ship space relative to the entity pivot
+		desc.AddMember(&CShipThrusterComponent::m_localPosition, 'tpos', "position", "Position", "Thruster position in ship space", ZERO);
+		desc.AddMember(&CShipThrusterComponent::m_localDirection, 'tdir', "direction", "Thrust Direction", "Direction the thruster pushes the ship, in ship space", Vec3(0.f, 1.f, 0.f));
+		desc.AddMember(&CShipThrusterComponent::m_maxForce, 'tmxf', "maxforce", "Max Force", "Force at full throttle in newtons", 0.f);
+		desc.AddMember(&CShipThrusterComponent::m_overclockMultiplier, 'tocm', "overclock", "Overclock multiplier", "Force multiplier while overclocked", 1.5f);
 	}
 	virtual void ProcessEvent(const SEntityEvent& event) override;
 	virtual void Initialize() override;
+	// Every component of the entity is still valid here, unlike in the destructor
+	virtual void OnShutDown() override;
 	virtual Cry::Entity::EventFlags GetEventMask() const override;
 
 	// Get current thruster state
@@ -37,10 +47,21 @@ public:
 	{
 		return m_currentThrusterState;
 	};
+	void SetThrusterState(EShipThrusterState state);
+
+	// Layout read by the control allocation
+	const Vec3& GetLocalPosition() const { return m_localPosition; }
+	const Vec3& GetLocalDirection() const { return m_localDirection; }
+	// Max force taking the thruster state into account
+	float GetAvailableForce() const;
+
+	// Throttle (0-1) of the last allocation
+	float GetThrottle() const { return m_throttle; }
+	void SetThrottle(float throttle) { m_throttle = throttle; }
 
-	// Flight Behavior
-	void ApplyLinearImpulse(IPhysicalEntity* pPhysicalEntity, const Vec3& linearImpulse);
-	void ApplyAngularImpulse(IPhysicalEntity* pPhysicalEntity, const Vec3& angularImpulse);
+	// Flight Behavior, the impulses are added to the ship's wrench and committed with its next flight step
+	void ApplyLinearImpulse(const Vec3& linearImpulse);
+	void ApplyAngularImpulse(const Vec3& angularImpulse);
 
 protected:
 private:
@@ -50,11 +71,18 @@ private:
 
 	// Variables
 	bool hasGameStarted = false;
-	pe_action_impulse impulseAction;
 	float jerkRate = 0.f;
 
 	// Thruster state
-	EShipThrusterState m_currentThrusterState;
+	EShipThrusterState m_currentThrusterState = EShipThrusterState::Active;
+
+	// Layout
+	Vec3 m_localPosition = ZERO;
+	Vec3 m_localDirection = Vec3(0.f, 1.f, 0.f);
+	float m_maxForce = 0.f;
+	float m_overclockMultiplier = 1.5f;
+
+	float m_throttle = 0.f;
 
 	//Debug color
 	float m_debugColor[4] = { 1, 0, 0, 1 };
@@ -0,0 +1,275 @@
+// Copyright 2017-2019 Crytek GmbH / Crytek Group. All rights reserved.
+#include "StdAfx.h"
+#include "ThrusterAllocator.h"
+
+#include <algorithm>
+
+#include <Components/ShipThrusterComponent.h>
+
+namespace
+{
+	// Tikhonov damping relative to the average thruster effectiveness, keeps near-singular layouts (e.g. no roll authority) stable
+	constexpr double kDamping = 1e-4;
+
+	// Inverts a 6x6 matrix in place with Gauss-Jordan elimination. Returns false if it is singular.
+	bool Invert6x6(double (&matrix)[CThrusterAllocator::kWrenchSize][CThrusterAllocator::kWrenchSize])
+	{
+		constexpr size_t size = CThrusterAllocator::kWrenchSize;
+		double inverse[size][size] = {};
+		for (size_t i = 0; i < size; ++i)
+			inverse[i][i] = 1.0;
+
+		for (size_t column = 0; column < size; ++column)
+		{
+			// Partial pivoting
+			size_t pivot = column;
+			for (size_t row = column + 1; row < size; ++row)
+			{
+				if (fabs(matrix[row][column]) > fabs(matrix[pivot][column]))
+					pivot = row;
+			}
+
+			if (fabs(matrix[pivot][column]) < 1e-12)
+				return false;
+
+			if (pivot != column)
+			{
+				std::swap(matrix[pivot], matrix[column]);
+				std::swap(inverse[pivot], inverse[column]);
+			}
+
+			const double invPivot = 1.0 / matrix[column][column];
+			for (size_t k = 0; k < size; ++k)
+			{
+				matrix[column][k] *= invPivot;
+				inverse[column][k] *= invPivot;
+			}
+
+			for (size_t row = 0; row < size; ++row)
+			{
+				if (row == column)
+					continue;
+
+				const double factor = matrix[row][column];
+				for (size_t k = 0; k < size; ++k)
+				{
+					matrix[row][k] -= factor * matrix[column][k];
+					inverse[row][k] -= factor * inverse[column][k];
+				}
+			}
+		}
+
+		std::copy(&inverse[0][0], &inverse[0][0] + size * size, &matrix[0][0]);
+		return true;
+	}
+
+	// (B B^T + damping)^-1 in place from B B^T. Returns false without any authority.
+	bool InvertDampedGram(double (&gram)[CThrusterAllocator::kWrenchSize][CThrusterAllocator::kWrenchSize])
+	{
+		constexpr size_t size = CThrusterAllocator::kWrenchSize;
+		double trace = 0.0;
+		for (size_t k = 0; k < size; ++k)
+			trace += gram[k][k];
+
+		if (trace <= 0.0)
+			return false;
+
+		const double damping = kDamping * trace / (double)size;
+		for (size_t k = 0; k < size; ++k)
+			gram[k][k] += damping;
+
+		return Invert6x6(gram);
+	}
+}
+
+void CThrusterAllocator::AddThruster(CShipThrusterComponent* pThruster)
+{
+	if (std::find(m_thrusters.begin(), m_thrusters.end(), pThruster) == m_thrusters.end())
+	{
+		m_thrusters.push_back(pThruster);
+		m_isDirty = true;
+	}
+}
+
+void CThrusterAllocator::RemoveThruster(CShipThrusterComponent* pThruster)
+{
+	auto it = std::find(m_thrusters.begin(), m_thrusters.end(), pThruster);
+	if (it != m_thrusters.end())
+	{
+		m_thrusters.erase(it);
+		m_isDirty = true;
+	}
+}
+
+void CThrusterAllocator::Rebuild()
+{
+	const size_t count = m_thrusters.size();
+	m_effectiveness.assign(count * kWrenchSize, 0.f);
+	m_pseudoInverse.assign(count * kWrenchSize, 0.f);
+	m_throttles.assign(count, 0.f);
+	m_isFree.assign(count, 1);
+	m_isDirty = false;
+	m_hasAuthority = false;
+
+	// Effectiveness B (6 x N), stored per thruster: force = direction * capacity, torque = position x force
+	for (size_t i = 0; i < count; ++i)
+	{
+		const CShipThrusterComponent* pThruster = m_thrusters[i];
+		const Vec3 force = pThruster->GetLocalDirection().GetNormalizedSafe(Vec3(ZERO)) * pThruster->GetAvailableForce();
+		const Vec3 torque = pThruster->GetLocalPosition().Cross(force);
+
+		float* pColumn = &m_effectiveness[i * kWrenchSize];
+		pColumn[0] = force.x; pColumn[1] = force.y; pColumn[2] = force.z;
+		pColumn[3] = torque.x; pColumn[4] = torque.y; pColumn[5] = torque.z;
+	}
+
+	// B * B^T + damping
+	double gram[kWrenchSize][kWrenchSize] = {};
+	for (size_t i = 0; i < count; ++i)
+	{
+		const float* pColumn = &m_effectiveness[i * kWrenchSize];
+		for (size_t row = 0; row < kWrenchSize; ++row)
+			for (size_t column = 0; column < kWrenchSize; ++column)
+				gram[row][column] += (double)pColumn[row] * (double)pColumn[column];
+	}
+
+	if (!InvertDampedGram(gram))
+		return;
+
+	// Pseudo-inverse B^T (B B^T + damping)^-1, N x 6
+	for (size_t i = 0; i < count; ++i)
+	{
+		const float* pColumn = &m_effectiveness[i * kWrenchSize];
+		float* pRow = &m_pseudoInverse[i * kWrenchSize];
+		for (size_t column = 0; column < kWrenchSize; ++column)
+		{
+			double value = 0.0;
+			for (size_t k = 0; k < kWrenchSize; ++k)
+				value += (double)pColumn[k] * gram[k][column];
+			pRow[column] = (float)value;
+		}
+	}
+
+	m_hasAuthority = true;
+}
+
+bool CThrusterAllocator::HasAuthority()
+{
+	if (m_isDirty)
+		Rebuild();
+
+	return m_hasAuthority;
+}
+
+void CThrusterAllocator::Allocate(const Vec3& force, const Vec3& torque, Vec3& achievedForce, Vec3& achievedTorque)
+{
+	if (m_isDirty)
+		Rebuild();
+
+	const size_t count = m_thrusters.size();
+	const float wrench[kWrenchSize] = { force.x, force.y, force.z, torque.x, torque.y, torque.z };
+	float achieved[kWrenchSize] = {};
+
+	const float* __restrict pseudoInverse = m_pseudoInverse.data();
+	const float* __restrict effectiveness = m_effectiveness.data();
+	float* __restrict throttles = m_throttles.data();
+
+	// Minimum norm answer from the cached pseudo-inverse, final unless a thruster would pull or go past full throttle
+	bool isSaturated = false;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const float* __restrict pRow = pseudoInverse + i * kWrenchSize;
+		float throttle = 0.f;
+		for (size_t k = 0; k < kWrenchSize; ++k)
+			throttle += pRow[k] * wrench[k];
+
+		throttles[i] = throttle;
+		isSaturated |= throttle < 0.f || throttle > 1.f;
+	}
+
+	if (isSaturated)
+		SolveBounded(wrench);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		// Thrusters only push
+		throttles[i] = crymath::clamp(throttles[i], 0.f, 1.f);
+
+		const float* __restrict pColumn = effectiveness + i * kWrenchSize;
+		for (size_t k = 0; k < kWrenchSize; ++k)
+			achieved[k] += pColumn[k] * throttles[i];
+	}
+
+	for (size_t i = 0; i < count; ++i)
+		m_thrusters[i]->SetThrottle(throttles[i]);
+
+	achievedForce = Vec3(achieved[0], achieved[1], achieved[2]);
+	achievedTorque = Vec3(achieved[3], achieved[4], achieved[5]);
+}
+
+void CThrusterAllocator::SolveBounded(const float (&wrench)[kWrenchSize])
+{
+	const size_t count = m_thrusters.size();
+	const float* __restrict effectiveness = m_effectiveness.data();
+	float* __restrict throttles = m_throttles.data();
+	uint8* __restrict isFree = m_isFree.data();
+
+	std::fill(m_isFree.begin(), m_isFree.end(), 1);
+
+	for (size_t iteration = 0; iteration < kMaxBoundIterations; ++iteration)
+	{
+		// Thrusters past a bound are held there
+		bool hasViolation = false;
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (isFree[i] && (throttles[i] < 0.f || throttles[i] > 1.f))
+			{
+				throttles[i] = crymath::clamp(throttles[i], 0.f, 1.f);
+				isFree[i] = 0;
+				hasViolation = true;
+			}
+		}
+
+		if (!hasViolation)
+			return;
+
+		// The rest of the wrench goes to the free thrusters: the other side of an opposing pair takes all of it
+		double remaining[kWrenchSize] = { wrench[0], wrench[1], wrench[2], wrench[3], wrench[4], wrench[5] };
+		double gram[kWrenchSize][kWrenchSize] = {};
+		for (size_t i = 0; i < count; ++i)
+		{
+			const float* __restrict pColumn = effectiveness + i * kWrenchSize;
+			if (!isFree[i])
+			{
+				for (size_t k = 0; k < kWrenchSize; ++k)
+					remaining[k] -= (double)pColumn[k] * throttles[i];
+				continue;
+			}
+
+			for (size_t row = 0; row < kWrenchSize; ++row)
+				for (size_t column = 0; column < kWrenchSize; ++column)
+					gram[row][column] += (double)pColumn[row] * (double)pColumn[column];
+		}
+
+		if (!InvertDampedGram(gram))
+			return;
+
+		// Throttles B_free^T (B_free B_free^T + damping)^-1 remaining
+		double solved[kWrenchSize] = {};
+		for (size_t row = 0; row < kWrenchSize; ++row)
+			for (size_t k = 0; k < kWrenchSize; ++k)
+				solved[row] += gram[row][k] * remaining[k];
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (!isFree[i])
+				continue;
+
+			const float* __restrict pColumn = effectiveness + i * kWrenchSize;
+			double throttle = 0.0;
+			for (size_t k = 0; k < kWrenchSize; ++k)
+				throttle += (double)pColumn[k] * solved[k];
+			throttles[i] = (float)throttle;
+		}
+	}
+}
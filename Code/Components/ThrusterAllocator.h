@@ -0,0 +1,52 @@
+// Copyright 2017-2021 Crytek GmbH / Crytek Group. All rights reserved.
+#pragma once
+#include <vector>
+
+class CShipThrusterComponent;
+
+////////////////////////////////////////////////////////
+// Control allocation: maps a wanted ship space force / torque to thruster throttles.
+// The damped pseudo-inverse of the 6xN effectiveness matrix is cached and only rebuilt when the layout or a thruster state changes,
+// so the per-frame cost is one Nx6 matrix-vector product. When that answer needs a thruster to pull or go past full throttle,
+// saturated thrusters are held at their bound and the rest of the wrench is solved again over the others (SolveBounded).
+////////////////////////////////////////////////////////
+class CThrusterAllocator
+{
+public:
+	static constexpr size_t kWrenchSize = 6; // force xyz, torque xyz
+	// Passes of SolveBounded, each holds at least one more thruster at a bound
+	static constexpr size_t kMaxBoundIterations = 4;
+
+	CThrusterAllocator() = default;
+	~CThrusterAllocator() = default;
+
+	void AddThruster(CShipThrusterComponent* pThruster);
+	void RemoveThruster(CShipThrusterComponent* pThruster);
+	bool IsEmpty() const { return m_thrusters.empty(); }
+
+	// True when the thrusters can produce any wrench (rebuilds if needed). Without authority the caller keeps its own thrust.
+	bool HasAuthority();
+
+	// Thruster position, direction, max force or state changed
+	void MarkDirty() { m_isDirty = true; }
+
+	// Throttles every thruster (0-1) for the wanted ship space force / torque, and returns what the thrusters can actually deliver
+	void Allocate(const Vec3& force, const Vec3& torque, Vec3& achievedForce, Vec3& achievedTorque);
+
+private:
+	void Rebuild();
+	// Bounded least squares over m_throttles, starting from the unconstrained answer
+	void SolveBounded(const float (&wrench)[kWrenchSize]);
+
+	std::vector<CShipThrusterComponent*> m_thrusters;
+
+	// Per thruster effectiveness at full throttle (force xyz, torque xyz), N x 6
+	std::vector<float> m_effectiveness;
+	// Damped pseudo-inverse, N x 6
+	std::vector<float> m_pseudoInverse;
+	std::vector<float> m_throttles;
+	std::vector<uint8> m_isFree; // Per thruster, not held at a bound by SolveBounded
+
+	bool m_isDirty = true;
+	bool m_hasAuthority = false;
+};
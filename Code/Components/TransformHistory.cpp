@@ -0,0 +1,246 @@
+// Copyright 2017-2019 Crytek GmbH / Crytek Group. All rights reserved.
+#include "StdAfx.h"
+#include "TransformHistory.h"
+
+#include <algorithm>
+#include <CrySystem/ConsoleRegistration.h>
+#include <CrySystem/IConsole.h>
+
+#include "GamePlugin.h"
+#include <Components/FlightController.h>
+#include <Components/FlightSystem.h>
+#include <Components/Player.h>
+
+namespace
+{
+	// Slab test in the space of the bounds, distance to the entry point (0 if the ray starts inside)
+	bool IntersectRayBounds(const Vec3& origin, const Vec3& direction, const AABB& bounds, float& distance)
+	{
+		float tMin = 0.f;
+		float tMax = FLT_MAX;
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			if (fabsf(direction[axis]) < FLT_EPSILON)
+			{
+				if (origin[axis] < bounds.min[axis] || origin[axis] > bounds.max[axis])
+					return false;
+				continue;
+			}
+
+			const float invDirection = 1.f / direction[axis];
+			float t0 = (bounds.min[axis] - origin[axis]) * invDirection;
+			float t1 = (bounds.max[axis] - origin[axis]) * invDirection;
+			if (t0 > t1)
+				std::swap(t0, t1);
+
+			tMin = std::max(tMin, t0);
+			tMax = std::min(tMax, t1);
+			if (tMin > tMax)
+				return false;
+		}
+
+		distance = tMin;
+		return true;
+	}
+}
+
+float CTransformHistory::s_maxRewind = 0.5f;
+int CTransformHistory::s_debug = 0;
+
+void CTransformHistory::Update(float frameTime)
+{
+	if (!gEnv->bServer || gEnv->IsEditing())
+		return;
+
+	m_recordTimer -= frameTime;
+	if (m_recordTimer > 0.f)
+		return;
+
+	m_recordTimer = std::max(m_recordTimer + 1.f / kRecordRate, 0.f);
+	Record(CFlightSystem::GetInstance().GetLevelTime());
+}
+
+void CTransformHistory::Clear()
+{
+	m_recordCount = 0;
+	m_recordTimer = 0.f;
+
+	m_entityIds.clear();
+	m_localBounds.clear();
+	m_isShip.clear();
+	m_firstRecord.clear();
+	m_lastRecord.clear();
+	m_positions.clear();
+	m_orientations.clear();
+	m_slots.clear();
+	m_freeSlots.clear();
+}
+
+void CTransformHistory::Record(float time)
+{
+	const uint32 frame = GetFrame(m_recordCount);
+	m_frameTimes[frame] = time;
+
+	for (CFlightController* pController : CFlightSystem::GetInstance().GetControllers())
+	{
+		// Free slots are null
+		if (pController)
+			RecordEntity(*pController->GetEntity(), true, frame);
+	}
+
+	CGamePlugin::GetInstance()->IterateOverPlayers([this, frame](CPlayerComponent& player)
+	{
+		// Pilots are hidden inside their ship, the ship is the target
+		const IEntity& entity = *player.GetEntity();
+		if (!entity.IsHidden())
+			RecordEntity(entity, false, frame);
+	});
+
+	// Entities missing from this frame are gone (removed, or a player who boarded a ship)
+	for (uint32 slot = 0; slot < (uint32)m_entityIds.size(); ++slot)
+	{
+		if (m_entityIds[slot] != INVALID_ENTITYID && m_lastRecord[slot] != m_recordCount)
+		{
+			m_slots.erase(m_entityIds[slot]);
+			m_entityIds[slot] = INVALID_ENTITYID;
+			m_freeSlots.push_back(slot);
+		}
+	}
+
+	++m_recordCount;
+}
+
+void CTransformHistory::RecordEntity(const IEntity& entity, bool isShip, uint32 frame)
+{
+	auto it = m_slots.find(entity.GetId());
+	const uint32 slot = it != m_slots.end() ? it->second : AllocateSlot(entity.GetId());
+
+	entity.GetLocalBounds(m_localBounds[slot]);
+	m_isShip[slot] = isShip ? 1 : 0;
+	m_lastRecord[slot] = m_recordCount;
+
+	m_positions[slot * kFrameCount + frame] = entity.GetWorldPos();
+	m_orientations[slot * kFrameCount + frame] = entity.GetWorldRotation();
+}
+
+uint32 CTransformHistory::AllocateSlot(EntityId entityId)
+{
+	uint32 slot;
+	if (!m_freeSlots.empty())
+	{
+		slot = m_freeSlots.back();
+		m_freeSlots.pop_back();
+	}
+	else
+	{
+		slot = (uint32)m_entityIds.size();
+		m_entityIds.push_back(INVALID_ENTITYID);
+		m_localBounds.push_back(AABB(ZERO));
+		m_isShip.push_back(0);
+		m_firstRecord.push_back(0);
+		m_lastRecord.push_back(0);
+		m_positions.resize(m_positions.size() + kFrameCount, ZERO);
+		m_orientations.resize(m_orientations.size() + kFrameCount, IDENTITY);
+	}
+
+	m_entityIds[slot] = entityId;
+	m_firstRecord[slot] = m_recordCount;
+	m_slots.emplace(entityId, slot);
+	return slot;
+}
+
+bool CTransformHistory::GetFrameBlend(float time, SFrameBlend& blend) const
+{
+	if (m_recordCount == 0)
+		return false;
+
+	const uint32 newest = m_recordCount - 1;
+	const uint32 oldest = m_recordCount > kFrameCount ? m_recordCount - kFrameCount : 0;
+
+	blend.fromRecord = blend.toRecord = newest;
+	blend.alpha = 0.f;
+	if (time >= m_frameTimes[GetFrame(newest)])
+		return true;
+
+	for (uint32 record = newest; record > oldest; --record)
+	{
+		const float olderTime = m_frameTimes[GetFrame(record - 1)];
+		if (time >= olderTime)
+		{
+			const float newerTime = m_frameTimes[GetFrame(record)];
+			blend.fromRecord = record - 1;
+			blend.toRecord = record;
+			blend.alpha = newerTime > olderTime ? (time - olderTime) / (newerTime - olderTime) : 1.f;
+			return true;
+		}
+	}
+
+	// Older than the history, the oldest frame is as far as it goes
+	blend.fromRecord = blend.toRecord = oldest;
+	return true;
+}
+
+QuatT CTransformHistory::GetPose(uint32 slot, const SFrameBlend& blend) const
+{
+	// Entities added after the requested frame are held at their first pose
+	const uint32 base = slot * kFrameCount;
+	const uint32 from = base + GetFrame(std::max(blend.fromRecord, m_firstRecord[slot]));
+	const uint32 to = base + GetFrame(std::max(blend.toRecord, m_firstRecord[slot]));
+
+	return QuatT(Quat::CreateSlerp(m_orientations[from], m_orientations[to], blend.alpha), Vec3::CreateLerp(m_positions[from], m_positions[to], blend.alpha));
+}
+
+bool CTransformHistory::RayCast(const Vec3& origin, const Vec3& direction, float maxDistance, const SViewTime& viewTime, EntityId ignoreId, SHit& hit) const
+{
+	// No view time (no state received yet): the present
+	const float now = CFlightSystem::GetInstance().GetLevelTime();
+	const float playerTime = viewTime.time > 0.f ? crymath::clamp(viewTime.time, now - s_maxRewind, now) : now;
+	const float shipTime = viewTime.time > 0.f ? crymath::clamp(viewTime.time - viewTime.interpolationDelay, now - s_maxRewind, now) : now;
+
+	SFrameBlend playerBlend;
+	SFrameBlend shipBlend;
+	if (!GetFrameBlend(playerTime, playerBlend) || !GetFrameBlend(shipTime, shipBlend))
+		return false;
+
+	hit.entityId = INVALID_ENTITYID;
+	hit.distance = maxDistance;
+
+	for (uint32 slot = 0; slot < (uint32)m_entityIds.size(); ++slot)
+	{
+		if (m_entityIds[slot] == INVALID_ENTITYID || m_entityIds[slot] == ignoreId)
+			continue;
+
+		// The ray goes into the space of the rewound entity, its bounds stay axis aligned there
+		const QuatT pose = GetPose(slot, m_isShip[slot] ? shipBlend : playerBlend);
+		const Quat inverseRotation = !pose.q;
+
+		float distance;
+		if (IntersectRayBounds(inverseRotation * (origin - pose.t), inverseRotation * direction, m_localBounds[slot], distance) && distance < hit.distance)
+		{
+			hit.entityId = m_entityIds[slot];
+			hit.distance = distance;
+		}
+	}
+
+	hit.position = origin + direction * hit.distance;
+	return hit.entityId != INVALID_ENTITYID;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// CONSOLE
+///////////////////////////////////////////////////////////////////////////
+void CTransformHistory::RegisterConsoleCommands()
+{
+	REGISTER_CVAR2("lagcomp_maxRewind", &s_maxRewind, s_maxRewind, VF_NULL, "Seconds a shot can rewind its targets, the history itself holds about one second");
+	REGISTER_CVAR2("lagcomp_debug", &s_debug, s_debug, VF_NULL, "1 logs every lag compensated shot and its hit");
+}
+
+void CTransformHistory::UnregisterConsoleCommands()
+{
+	if (gEnv->pConsole)
+	{
+		gEnv->pConsole->UnregisterVariable("lagcomp_maxRewind");
+		gEnv->pConsole->UnregisterVariable("lagcomp_debug");
+	}
+}
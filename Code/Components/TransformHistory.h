@@ -0,0 +1,96 @@
+// Copyright 2017-2021 Crytek GmbH / Crytek Group. All rights reserved.
+#pragma once
+#include <array>
+#include <unordered_map>
+#include <vector>
+
+////////////////////////////////////////////////////////
+// Server side history of the transforms and bounds of every ship and player on foot, about a second at kRecordRate.
+// Shots are checked against the targets rewound to the moment the shooter saw them, with interpolated poses only (no physics).
+// Storage is a structure of arrays, the frames of an entity are contiguous:
+//   frame times: one ring shared by all entities
+//   positions / orientations: [slot * kFrameCount + frame]
+////////////////////////////////////////////////////////
+class CTransformHistory
+{
+public:
+	static constexpr uint32 kFrameCount = 64;
+	static constexpr float kRecordRate = 60.f;
+
+	static CTransformHistory& GetInstance()
+	{
+		static CTransformHistory instance;
+		return instance;
+	}
+
+	// The moment a shooter was looking at, on the server timeline.
+	// Remote ships are played back interpolationDelay behind the player states on the shooter's client.
+	struct SViewTime
+	{
+		float time = 0.f;
+		float interpolationDelay = 0.f;
+	};
+
+	struct SHit
+	{
+		EntityId entityId = INVALID_ENTITYID;
+		Vec3 position = ZERO;
+		float distance = 0.f;
+	};
+
+	// Server only, called once per frame after the flight system
+	void Update(float frameTime);
+	void Clear();
+
+	// Closest rewound target along the ray (direction normalized), ignoring one entity (the shooter). Rewinds at most lagcomp_maxRewind.
+	bool RayCast(const Vec3& origin, const Vec3& direction, float maxDistance, const SViewTime& viewTime, EntityId ignoreId, SHit& hit) const;
+
+	static void RegisterConsoleCommands();
+	static void UnregisterConsoleCommands();
+
+	static bool IsDebugEnabled() { return s_debug != 0; }
+
+private:
+	CTransformHistory() = default;
+	CTransformHistory(const CTransformHistory&) = delete;
+	CTransformHistory& operator=(const CTransformHistory&) = delete;
+
+	// Two recorded frames around a time, and the blend between them
+	struct SFrameBlend
+	{
+		uint32 fromRecord = 0;
+		uint32 toRecord = 0;
+		float alpha = 0.f;
+	};
+
+	void Record(float time);
+	void RecordEntity(const IEntity& entity, bool isShip, uint32 frame);
+	uint32 AllocateSlot(EntityId entityId);
+	bool GetFrameBlend(float time, SFrameBlend& blend) const;
+	QuatT GetPose(uint32 slot, const SFrameBlend& blend) const;
+
+	static uint32 GetFrame(uint32 record) { return record % kFrameCount; }
+
+	// Shared frame times, indexed by record % kFrameCount
+	std::array<float, kFrameCount> m_frameTimes;
+	uint32 m_recordCount = 0;
+	float m_recordTimer = 0.f;
+
+	// Per slot
+	std::vector<EntityId> m_entityIds;
+	std::vector<AABB> m_localBounds;
+	std::vector<uint8> m_isShip;
+	std::vector<uint32> m_firstRecord;
+	std::vector<uint32> m_lastRecord;
+
+	// Per slot and frame
+	std::vector<Vec3> m_positions;
+	std::vector<Quat> m_orientations;
+
+	std::unordered_map<EntityId, uint32> m_slots;
+	std::vector<uint32> m_freeSlots;
+
+	// CVars
+	static float s_maxRewind;
+	static int s_debug;
+};
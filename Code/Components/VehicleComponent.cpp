@@ -16,6 +16,7 @@
 #include <DefaultComponents/Input/InputComponent.h>
 #include <DefaultComponents/Physics/RigidBodyComponent.h>
 #include <Components/FlightController.h>
+#include <Components/VehicleIndex.h>
 
 // Registers the component to be used in the engine
 static void RegisterVehicleComponent(Schematyc::IEnvRegistrar& registrar)
@@ -31,6 +32,11 @@ static void RegisterVehicleComponent(Schematyc::IEnvRegistrar& registrar)
 
 CRY_STATIC_AUTO_REGISTER_FUNCTION(&RegisterVehicleComponent)
 
+CVehicleComponent::~CVehicleComponent()
+{
+	CVehicleIndex::GetInstance().Remove(GetEntityId());
+}
+
 void CVehicleComponent::Initialize()
 {
 	m_pRigidBodyComponent = m_pEntity->GetOrCreateComponent<Cry::DefaultComponents::CRigidBodyComponent>();
@@ -45,7 +51,7 @@ void CVehicleComponent::Initialize()
 Cry::Entity::EventFlags CVehicleComponent::GetEventMask() const
 {
 	//Listening to the update event
-	return EEntityEvent::GameplayStarted | EEntityEvent::Reset;
+	return EEntityEvent::GameplayStarted | EEntityEvent::Reset | EEntityEvent::TransformChanged;
 }
 
 void CVehicleComponent::ProcessEvent(const SEntityEvent& event)
@@ -55,12 +61,21 @@ void CVehicleComponent::ProcessEvent(const SEntityEvent& event)
 	case EEntityEvent::GameplayStarted:
 	{
 		m_hasGameStarted = true;
+		CVehicleIndex::GetInstance().Add(*GetEntity());
 	}
 	break;
 	case EEntityEvent::Reset:
 	{
 		m_hasGameStarted = false;
+		CVehicleIndex::GetInstance().Remove(GetEntityId());
 	}
+	break;
+	case EEntityEvent::TransformChanged:
+	{
+		// Only re-buckets the vehicle when it crosses a cell
+		CVehicleIndex::GetInstance().Move(GetEntityId(), GetEntity()->GetWorldTM());
+	}
+	break;
 	}
 }
 
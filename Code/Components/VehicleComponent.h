@@ -22,7 +22,7 @@ class CVehicleComponent final : public IEntityComponent
 
 public:
 	CVehicleComponent() = default;
-	virtual ~CVehicleComponent() = default;
+	virtual ~CVehicleComponent();
 
 	virtual void Initialize() override;
 
@@ -0,0 +1,170 @@
+// Copyright 2017-2019 Crytek GmbH / Crytek Group. All rights reserved.
+#include "StdAfx.h"
+#include "VehicleIndex.h"
+
+#include <algorithm>
+
+#include <Components/VehicleComponent.h>
+
+void CVehicleIndex::Add(const IEntity& entity)
+{
+	if (m_slots.count(entity.GetId()) != 0)
+		return;
+
+	uint32 slot;
+	if (!m_freeSlots.empty())
+	{
+		slot = m_freeSlots.back();
+		m_freeSlots.pop_back();
+	}
+	else
+	{
+		slot = (uint32)m_entityIds.size();
+		m_entityIds.push_back(INVALID_ENTITYID);
+		m_localCenters.push_back(ZERO);
+		m_positions.push_back(ZERO);
+		m_radii.push_back(0.f);
+		m_cellKeys.push_back(0);
+	}
+
+	// Bounding sphere around the center of the local bounds, the origin of a mesh is rarely its center
+	AABB localBounds;
+	entity.GetLocalBounds(localBounds);
+	const Vec3 scale = entity.GetScale();
+
+	m_entityIds[slot] = entity.GetId();
+	m_localCenters[slot] = localBounds.GetCenter();
+	m_positions[slot] = entity.GetWorldTM().TransformPoint(m_localCenters[slot]);
+	m_radii[slot] = localBounds.GetRadius() * std::max(std::max(scale.x, scale.y), scale.z);
+	m_cellKeys[slot] = GetCellKey(m_positions[slot]);
+	m_maxRadius = std::max(m_maxRadius, m_radii[slot]);
+
+	m_slots.emplace(entity.GetId(), slot);
+	m_cells[m_cellKeys[slot]].push_back(slot);
+}
+
+void CVehicleIndex::Remove(EntityId entityId)
+{
+	auto it = m_slots.find(entityId);
+	if (it == m_slots.end())
+		return;
+
+	const uint32 slot = it->second;
+	RemoveFromCell(m_cellKeys[slot], slot);
+	m_entityIds[slot] = INVALID_ENTITYID;
+	m_freeSlots.push_back(slot);
+	m_slots.erase(it);
+}
+
+void CVehicleIndex::Move(EntityId entityId, const Matrix34& worldTM)
+{
+	auto it = m_slots.find(entityId);
+	if (it == m_slots.end())
+		return;
+
+	const uint32 slot = it->second;
+	const Vec3 position = worldTM.TransformPoint(m_localCenters[slot]);
+	m_positions[slot] = position;
+
+	// Most moves stay in the cell
+	const uint64 cellKey = GetCellKey(position);
+	if (cellKey == m_cellKeys[slot])
+		return;
+
+	RemoveFromCell(m_cellKeys[slot], slot);
+	m_cellKeys[slot] = cellKey;
+	m_cells[cellKey].push_back(slot);
+}
+
+void CVehicleIndex::Clear()
+{
+	m_entityIds.clear();
+	m_localCenters.clear();
+	m_positions.clear();
+	m_radii.clear();
+	m_cellKeys.clear();
+	m_slots.clear();
+	m_freeSlots.clear();
+	m_cells.clear();
+	m_maxRadius = 0.f;
+}
+
+void CVehicleIndex::RemoveFromCell(uint64 cellKey, uint32 slot)
+{
+	auto it = m_cells.find(cellKey);
+	if (it == m_cells.end())
+		return;
+
+	std::vector<uint32>& slots = it->second;
+	auto slotIt = std::find(slots.begin(), slots.end(), slot);
+	if (slotIt != slots.end())
+	{
+		*slotIt = slots.back();
+		slots.pop_back();
+	}
+
+	if (slots.empty())
+		m_cells.erase(it);
+}
+
+uint64 CVehicleIndex::GetCellKey(int x, int y, int z)
+{
+	// 21 bits per axis, about 67000 km across at the default cell size
+	return ((uint64)(x & 0x1fffff) << 42) | ((uint64)(y & 0x1fffff) << 21) | (uint64)(z & 0x1fffff);
+}
+
+uint64 CVehicleIndex::GetCellKey(const Vec3& position)
+{
+	return GetCellKey((int)floorf(position.x / kCellSize), (int)floorf(position.y / kCellSize), (int)floorf(position.z / kCellSize));
+}
+
+IEntity* CVehicleIndex::FindBoardable(const Vec3& origin, const Vec3& viewDirection, float range, float coneCos) const
+{
+	if (m_slots.empty())
+		return nullptr;
+
+	IEntity* pNearest = nullptr;
+	float nearestDistance = FLT_MAX;
+
+	// Only the cells the range can reach, vehicles are bucketed by their center so the largest one widens it
+	const float reach = range + m_maxRadius;
+	const int minX = (int)floorf((origin.x - reach) / kCellSize), maxX = (int)floorf((origin.x + reach) / kCellSize);
+	const int minY = (int)floorf((origin.y - reach) / kCellSize), maxY = (int)floorf((origin.y + reach) / kCellSize);
+	const int minZ = (int)floorf((origin.z - reach) / kCellSize), maxZ = (int)floorf((origin.z + reach) / kCellSize);
+
+	for (int x = minX; x <= maxX; ++x)
+	for (int y = minY; y <= maxY; ++y)
+	for (int z = minZ; z <= maxZ; ++z)
+	{
+		auto it = m_cells.find(GetCellKey(x, y, z));
+		if (it == m_cells.end())
+			continue;
+
+		for (uint32 slot : it->second)
+		{
+			const Vec3 toVehicle = m_positions[slot] - origin;
+			const float distance = toVehicle.GetLength();
+			const float surfaceDistance = std::max(distance - m_radii[slot], 0.f);
+			if (surfaceDistance > range || surfaceDistance >= nearestDistance)
+				continue;
+
+			// Inside the cone, or the view direction goes through its bounding sphere
+			const float alongView = toVehicle.Dot(viewDirection);
+			if (distance > m_radii[slot] && alongView < coneCos * distance)
+			{
+				if (alongView <= 0.f || (toVehicle - viewDirection * alongView).GetLength() > m_radii[slot])
+					continue;
+			}
+
+			IEntity* pEntity = gEnv->pEntitySystem->GetEntity(m_entityIds[slot]);
+			CVehicleComponent* pVehicle = pEntity ? pEntity->GetComponent<CVehicleComponent>() : nullptr;
+			if (!pVehicle || pVehicle->GetIsPiloting())
+				continue;
+
+			pNearest = pEntity;
+			nearestDistance = surfaceDistance;
+		}
+	}
+
+	return pNearest;
+}
@@ -0,0 +1,51 @@
+// Copyright 2017-2021 Crytek GmbH / Crytek Group. All rights reserved.
+#pragma once
+#include <unordered_map>
+#include <vector>
+
+////////////////////////////////////////////////////////
+// Uniform grid of the entities carrying a CVehicleComponent, broad phase of the boarding and targeting queries (the line of sight is a CRayCastService ray).
+// Cells are hashed, only occupied ones exist. A vehicle changes cell lists only when its transform crosses a cell border.
+////////////////////////////////////////////////////////
+class CVehicleIndex
+{
+public:
+	static constexpr float kCellSize = 32.f;
+
+	static CVehicleIndex& GetInstance()
+	{
+		static CVehicleIndex instance;
+		return instance;
+	}
+
+	void Add(const IEntity& entity);
+	void Remove(EntityId entityId);
+	// From the vehicle's transform changes
+	void Move(EntityId entityId, const Matrix34& worldTM);
+	void Clear();
+
+	// Nearest vehicle without a pilot, within range of the origin (bounding sphere around the bounds center) and within the view cone (half angle cosine)
+	IEntity* FindBoardable(const Vec3& origin, const Vec3& viewDirection, float range, float coneCos) const;
+
+private:
+	CVehicleIndex() = default;
+	CVehicleIndex(const CVehicleIndex&) = delete;
+	CVehicleIndex& operator=(const CVehicleIndex&) = delete;
+
+	static uint64 GetCellKey(int x, int y, int z);
+	static uint64 GetCellKey(const Vec3& position);
+	void RemoveFromCell(uint64 cellKey, uint32 slot);
+
+	// Per slot
+	std::vector<EntityId> m_entityIds;
+	std::vector<Vec3> m_localCenters; // Center of the local bounds
+	std::vector<Vec3> m_positions; // World center of the bounds
+	std::vector<float> m_radii;
+	std::vector<uint64> m_cellKeys;
+
+	std::unordered_map<EntityId, uint32> m_slots;
+	std::vector<uint32> m_freeSlots;
+	std::unordered_map<uint64, std::vector<uint32>> m_cells;
+	// Widens the searched cells, vehicles are bucketed by their bounds center
+	float m_maxRadius = 0.f;
+};
@@ -11,6 +11,15 @@
 #include <CrySystem/ConsoleRegistration.h>
 
 #include <Components/PlayerManager.h>
+#include <Components/BallisticsSystem.h>
+#include <Components/FireReplication.h>
+#include <Components/FlightRecorder.h>
+#include <Components/FlightSystem.h>
+#include <Components/ProjectilePool.h>
+#include <Components/RayCastService.h>
+#include <Components/ShipReplication.h>
+#include <Components/TransformHistory.h>
+#include <Components/VehicleIndex.h>
 #include "Components/Player.h"
 #include "Components/VehicleComponent.h"
 
@@ -29,6 +38,15 @@ CGamePlugin::~CGamePlugin()
 
 	gEnv->pSystem->GetISystemEventDispatcher()->RemoveListener(this);
 
+	CFlightSystem::GetInstance().Shutdown();
+	CFlightSystem::UnregisterConsoleCommands();
+	CFlightRecorder::UnregisterConsoleCommands();
+	CShipReplication::UnregisterConsoleCommands();
+	CTransformHistory::UnregisterConsoleCommands();
+	CProjectilePool::UnregisterConsoleCommands();
+	CBallisticsSystem::UnregisterConsoleCommands();
+	CRayCastService::UnregisterConsoleCommands();
+
 	if (gEnv->pSchematyc)
 	{
 		gEnv->pSchematyc->GetEnvRegistry().DeregisterPackage(CGamePlugin::GetCID());
@@ -44,9 +62,31 @@ bool CGamePlugin::Initialize(SSystemGlobalEnvironment& env, const SSystemInitPar
 	m_isPiloting = REGISTER_INT("is_piloting", value , VF_CHEAT, "is the player piloting");
 	m_isPiloting->Set(value);
 
+	CFlightSystem::RegisterConsoleCommands();
+	CFlightRecorder::RegisterConsoleCommands();
+	CShipReplication::RegisterConsoleCommands();
+	CTransformHistory::RegisterConsoleCommands();
+	CProjectilePool::RegisterConsoleCommands();
+	CBallisticsSystem::RegisterConsoleCommands();
+	CRayCastService::RegisterConsoleCommands();
+
+	// Every piloted ship is stepped by the flight system in one pass
+	EnableUpdate(EUpdateStep::MainUpdate, true);
+
 	return true;
 }
 
+void CGamePlugin::MainUpdate(float frameTime)
+{
+	// Ray callbacks first, so gameplay reacts to them this frame
+	CRayCastService::GetInstance().Update();
+	CFlightSystem::GetInstance().Update(frameTime);
+	CShipReplication::GetInstance().Update(frameTime);
+	CTransformHistory::GetInstance().Update(frameTime);
+	CBallisticsSystem::GetInstance().Update(frameTime);
+	CFireReplication::GetInstance().Update(frameTime);
+}
+
 void CGamePlugin::OnSystemEvent(ESystemEvent event, UINT_PTR wparam, UINT_PTR lparam)
 {
 	switch (event)
@@ -92,9 +132,25 @@ void CGamePlugin::OnSystemEvent(ESystemEvent event, UINT_PTR wparam, UINT_PTR lp
 		}
 		break;
 		
+		case ESYSTEM_EVENT_LEVEL_GAMEPLAY_START:
+		{
+			CFlightSystem::GetInstance().ResetLevelTime();
+
+			// Bullet visuals are spawned up front, rounds only show and move them
+			CProjectilePool::GetInstance().Prewarm();
+		}
+		break;
+
 		case ESYSTEM_EVENT_LEVEL_UNLOAD:
 		{
 			m_players.clear();
+			CTransformHistory::GetInstance().Clear();
+			CShipReplication::GetInstance().Clear();
+			CBallisticsSystem::GetInstance().Clear();
+			CFireReplication::GetInstance().Clear();
+			CRayCastService::GetInstance().Clear();
+			CProjectilePool::GetInstance().Clear();
+			CVehicleIndex::GetInstance().Clear();
 		}
 		break;
 	}
@@ -0,0 +1,210 @@
+// Copyright 2017-2019 Crytek GmbH / Crytek Group. All rights reserved.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include <Components/HeadlessFlightModel.h>
+
+////////////////////////////////////////////////////////
+// Headless flight model benchmark, built without the engine (see Tools/CMakeLists.txt).
+// Steps synthetic ships through scripted input traces in Newtonian and Coupled modes against a mock rigid body,
+// with the flight model and batch the game runs.
+//   FlightBenchmark [maxShips=1024] [steps=1000] [mode=both|newtonian|coupled] [maxThreads=cores]
+////////////////////////////////////////////////////////
+
+// Every heap allocation of the process goes through here, so the timed loop can count its own
+static std::atomic<size_t> s_allocationCount(0);
+
+void* operator new(size_t size)
+{
+	s_allocationCount.fetch_add(1, std::memory_order_relaxed);
+	if (void* pMemory = std::malloc(size ? size : 1))
+		return pMemory;
+	throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* pMemory) noexcept
+{
+	std::free(pMemory);
+}
+
+void operator delete[](void* pMemory) noexcept
+{
+	std::free(pMemory);
+}
+
+void operator delete(void* pMemory, size_t) noexcept
+{
+	std::free(pMemory);
+}
+
+void operator delete[](void* pMemory, size_t) noexcept
+{
+	std::free(pMemory);
+}
+
+namespace
+{
+	using Clock = std::chrono::high_resolution_clock;
+
+	constexpr float kFrameTime = 1.f / 60.f;
+	const SFlightVec3 kGravity(0.f, 0.f, -9.81f);
+
+	enum class EBenchmarkMode
+	{
+		Newtonian,
+		Coupled
+	};
+
+	// Scripted pilot: every ship follows the same trace with its own phase, pair axes (fwd / bwd...) never fire together
+	float TraceInput(int ship, int step, EShipAxis axis)
+	{
+		const float phase = (float)(step + ship * 37) * 0.02f + (float)axis * 0.7f;
+		const float value = std::sin(phase);
+
+		switch (axis)
+		{
+		case EShipAxis::Yaw:
+		case EShipAxis::Pitch:
+			return value;
+		default:
+			return std::max(((uint8_t)axis & 1) ? -value : value, 0.f);
+		}
+	}
+
+	// One shard of ships with its own flight model, so shards can run on separate threads
+	struct SBenchmarkShard
+	{
+		CHeadlessFlightModel model = CHeadlessFlightModel(CHeadlessFlightModel::GetReferenceProfile(), CHeadlessFlightModel::kReferenceMass, kGravity);
+		int firstShip = 0;
+
+		void Setup(int shipCount, int shipOffset)
+		{
+			firstShip = shipOffset;
+			for (int i = 0; i < shipCount; ++i)
+				model.AddShip();
+		}
+
+		void Step(EBenchmarkMode mode, int step)
+		{
+			const int shipCount = (int)model.GetShipCount();
+			for (int i = 0; i < shipCount; ++i)
+			{
+				SShipInputSnapshot input;
+				for (size_t axis = 0; axis < (size_t)EShipAxis::Count; ++axis)
+					input.SetAxis((EShipAxis)axis, TraceInput(firstShip + i, step, (EShipAxis)axis));
+
+				// Half of the ships hold against gravity
+				if (mode == EBenchmarkMode::Coupled)
+					input.modifiers.SetFlag(EFlightModifierFlag::Coupled);
+				if ((firstShip + i) & 1)
+					input.modifiers.SetFlag(EFlightModifierFlag::Gravity);
+
+				model.SetInput(i, input);
+			}
+
+			model.Step(kFrameTime);
+		}
+	};
+
+	const char* GetModeName(EBenchmarkMode mode)
+	{
+		return mode == EBenchmarkMode::Newtonian ? "newtonian" : "coupled";
+	}
+
+	// Runs shipCount ships split over threadCount shards, returns the wall time in ns
+	double RunSharded(EBenchmarkMode mode, int shipCount, int steps, int threadCount)
+	{
+		std::vector<SBenchmarkShard> shards(threadCount);
+		const int shipsPerShard = shipCount / threadCount;
+		for (int t = 0; t < threadCount; ++t)
+		{
+			const int count = t == threadCount - 1 ? shipCount - shipsPerShard * t : shipsPerShard;
+			shards[t].Setup(count, shipsPerShard * t);
+		}
+
+		const Clock::time_point start = Clock::now();
+
+		std::vector<std::thread> threads;
+		threads.reserve(threadCount);
+		for (SBenchmarkShard& shard : shards)
+		{
+			threads.emplace_back([&shard, mode, steps]()
+			{
+				for (int step = 0; step < steps; ++step)
+					shard.Step(mode, step);
+			});
+		}
+
+		for (std::thread& thread : threads)
+			thread.join();
+
+		return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const int maxShips = argc > 1 ? std::max(std::atoi(argv[1]), 1) : 1024;
+	const int steps = argc > 2 ? std::max(std::atoi(argv[2]), 1) : 1000;
+	const char* szMode = argc > 3 ? argv[3] : "both";
+	const int maxThreads = argc > 4 ? std::max(std::atoi(argv[4]), 1) : std::max((int)std::thread::hardware_concurrency(), 1);
+
+	std::vector<EBenchmarkMode> modes;
+	if (std::strcmp(szMode, "coupled") != 0)
+		modes.push_back(EBenchmarkMode::Newtonian);
+	if (std::strcmp(szMode, "newtonian") != 0)
+		modes.push_back(EBenchmarkMode::Coupled);
+
+	std::printf("[FlightBenchmark] %d steps per run, frame time %.4f\n", steps, kFrameTime);
+
+	for (EBenchmarkMode mode : modes)
+	{
+		// Doubling the ship count each run, the ns/ship column should stay flat
+		for (int shipCount = 1; shipCount <= maxShips; shipCount *= 2)
+		{
+			SBenchmarkShard shard;
+			shard.Setup(shipCount, 0);
+
+			// Warm up once so setup and first touch allocations are not counted
+			shard.Step(mode, 0);
+
+			const size_t allocationsBefore = s_allocationCount.load(std::memory_order_relaxed);
+			const Clock::time_point start = Clock::now();
+
+			for (int step = 1; step <= steps; ++step)
+				shard.Step(mode, step);
+
+			const double elapsedNs = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+			const size_t allocations = s_allocationCount.load(std::memory_order_relaxed) - allocationsBefore;
+
+			std::printf("[FlightBenchmark] %-9s | ships: %5d | %10.1f ns/step | %7.2f ns/ship/step | %.2f allocs/step\n",
+				GetModeName(mode), shipCount, elapsedNs / steps, elapsedNs / ((double)steps * shipCount), (double)allocations / steps);
+		}
+
+		// Throughput scaling across cores at the largest ship count
+		double singleThreadNs = 0.0;
+		for (int threadCount = 1; threadCount <= maxThreads && threadCount <= maxShips; threadCount *= 2)
+		{
+			const double elapsedNs = RunSharded(mode, maxShips, steps, threadCount);
+			if (threadCount == 1)
+				singleThreadNs = elapsedNs;
+
+			const double shipStepsPerSecond = (double)maxShips * steps / (elapsedNs * 1e-9);
+			std::printf("[FlightBenchmark] %-9s | threads: %3d | %12.0f ship steps/s | x%.2f\n", GetModeName(mode), threadCount, shipStepsPerSecond, singleThreadNs / elapsedNs);
+		}
+	}
+
+	return 0;
+}